@@ -0,0 +1,84 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// bump allocator: objects are placed one after another in large blocks and are
+// all destroyed and freed together by release() (or when the arena dies).
+// allocation is a pointer increment, and there is no per-object delete
+struct Arena {
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { release(); }
+
+    template<typename T, typename ... Args>
+    T* make(Args&& ... args) {
+        void* memory = allocate(sizeof(T), alignof(T));
+        ++object_count;
+        T* object = new (memory) T{std::forward<Args>(args)...};
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            destructors.push_back({ [](void* p) { static_cast<T*>(p)->~T(); }, object });
+        }
+        return object;
+    }
+
+    // destroy every object, newest first, and free all blocks
+    void release() {
+        for (auto it = destructors.rbegin(); it != destructors.rend(); ++it) {
+            it->destroy(it->object);
+        }
+        destructors.clear();
+        blocks.clear();
+        current = nullptr;
+        remaining = 0;
+    }
+
+    // bytes and objects handed out so far
+    size_t allocated() const { return allocated_bytes; }
+    size_t objects() const { return object_count; }
+
+private:
+    static constexpr size_t block_size = 64 * 1024;
+
+    void* allocate(size_t size, size_t alignment) {
+        size_t padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+        if (!current || padding + size > remaining) {
+            // oversized objects get a block of their own
+            size_t sz = std::max(block_size, size + alignment);
+            blocks.push_back(std::make_unique<std::byte[]>(sz));
+            current = blocks.back().get();
+            remaining = sz;
+            padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+        }
+        std::byte* p = current + padding;
+        current = p + size;
+        remaining -= padding + size;
+        allocated_bytes += size;
+        return p;
+    }
+
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::vector<Destructor> destructors;
+    std::byte* current = nullptr;
+    size_t remaining = 0;
+    size_t allocated_bytes = 0;
+    size_t object_count = 0;
+};
+
+// owns every node of the parse tree (and the lexer's token strings)
+extern Arena parse_arena;
+
+#endif
@@ -0,0 +1,112 @@
+#!/bin/bash
+
+# writes a synthetic Rhythm program to standard output
+#   procedures N  N procedures, each calling the previous one
+#   nesting N     N/100 statements, each an expression nested 100 levels deep
+#   overloads N   N overloads of one procedure, resolved at N call sites
+#   structs N     a struct with N fields, every field written and read
+
+usage="usage: $0 procedures|nesting|overloads|structs size"
+
+if [ $# -ne 2 ]
+then
+    echo $usage >&2
+    exit 1
+fi
+
+kind="$1"
+size="$2"
+
+procedures() {
+    echo "proc p0(a Int, b Int) Int {"
+    echo "    return a + b"
+    echo "}"
+    echo
+    for ((i = 1; i < size; i++)); do
+        echo "proc p$i(a Int, b Int) Int {"
+        echo "    c Int <- a * b + $i"
+        echo "    if c > 1000 && b != 0 {"
+        echo "        c <- c % 1000"
+        echo "    }"
+        echo "    while c > 10 {"
+        echo "        c <- c / 2"
+        echo "    }"
+        echo "    return p$((i - 1))(c, b - 1)"
+        echo "}"
+        echo
+    done
+    echo "proc main() Int {"
+    echo "    printf(\"%d\\n\", p$((size - 1))(3, 4))"
+    echo "    return 0"
+    echo "}"
+}
+
+nesting() {
+    # one statement per 100 levels so the parser stack stays bounded
+    echo "proc main() Int {"
+    echo "    x Int <- 1"
+    for ((i = 0; i < size; i += 100)); do
+        line="x"
+        for ((j = 0; j < 100 && i + j < size; j++)); do
+            case $((j % 3)) in
+                0) line="($line + $j)" ;;
+                1) line="($line * 3)" ;;
+                2) line="($line - $j) % 1000" ;;
+            esac
+        done
+        echo "    x <- $line"
+    done
+    echo "    printf(\"%d\\n\", x)"
+    echo "    return 0"
+    echo "}"
+}
+
+overloads() {
+    for ((i = 0; i < size; i++)); do
+        echo "typedef T$i Struct(value Int)"
+    done
+    echo
+    for ((i = 0; i < size; i++)); do
+        echo "proc get(t Pointer(T$i)) Int {"
+        echo "    return deref(t).value + $i"
+        echo "}"
+        echo
+    done
+    echo "proc main() Int {"
+    echo "    sum Int <- 0"
+    for ((i = 0; i < size; i++)); do
+        echo "    t$i T$i"
+        echo "    t$i.value <- $i"
+        echo "    sum <- sum + get(address(t$i))"
+    done
+    echo "    printf(\"%d\\n\", sum)"
+    echo "    return 0"
+    echo "}"
+}
+
+structs() {
+    fields="f0 Int"
+    for ((i = 1; i < size; i++)); do
+        fields="$fields, f$i Int"
+    done
+    echo "typedef Big Struct($fields)"
+    echo
+    echo "proc main() Int {"
+    echo "    b Big"
+    for ((i = 0; i < size; i++)); do
+        echo "    b.f$i <- $i"
+    done
+    echo "    sum Int <- 0"
+    for ((i = 0; i < size; i++)); do
+        echo "    sum <- sum + b.f$i"
+    done
+    echo "    printf(\"%d\\n\", sum)"
+    echo "    return 0"
+    echo "}"
+}
+
+case $kind in
+    procedures|nesting|overloads|structs) $kind ;;
+    *) echo $usage >&2
+       exit 1 ;;
+esac
@@ -0,0 +1,27 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+// layout of Particles in kernels.rh
+struct particles {
+    double* x;
+    double* y;
+    double* vx;
+    double* vy;
+    int n;
+};
+
+// kernels.rh, by mangled name
+int* rh_copy(int* f_i, int* l_i, int* f_o) __asm__("copy_Pointer._Int._Pointer._Int._Pointer._Int.");
+int rh_sum(int* f, int* l) __asm__("sum_Pointer._Int._Pointer._Int.");
+void rh_sort(int* f, int* l) __asm__("sort_Pointer._Int._Pointer._Int.");
+void rh_matmul(double* a, double* b, double* c, int n) __asm__("matmul_Pointer._Flt64._Pointer._Flt64._Pointer._Flt64._Int");
+void rh_advance(struct particles* p, double dt) __asm__("advance_Pointer._Particles._Flt64");
+
+// reference.c
+int* c_copy(int* f_i, int* l_i, int* f_o);
+int c_sum(int* f, int* l);
+void c_sort(int* f, int* l);
+void c_matmul(double* a, double* b, double* c, int n);
+void c_advance(struct particles* p, double dt);
+
+#endif
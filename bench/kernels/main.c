@@ -0,0 +1,193 @@
+// times each kernel of kernels.rh against its C reference (reference.c) and
+// prints ns per element, best of several runs.
+// usage: kernels [threshold]
+// kernels where rhythm is slower than C by more than threshold (default 1.25x)
+// are flagged, and the exit status is 2 if the two versions disagree
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "kernels.h"
+
+enum {
+    repetitions = 5,
+    array_size = 1 << 22,
+    sort_size = 1 << 13,
+    matrix_size = 160,
+    particle_count = 1 << 20,
+};
+
+static int* input;
+static int* output;
+static int* sort_input;
+static int* sorted;
+static double* a;
+static double* b;
+static double* c;
+static struct particles particles;
+static volatile int sink;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double* doubles(size_t n) {
+    double* p = malloc(n * sizeof(double));
+    for (size_t i = 0; i < n; ++i) {
+        p[i] = (double)(rand() % 1000) / 100;
+    }
+    return p;
+}
+
+static void setup(void) {
+    srand(1);
+    input = malloc(array_size * sizeof(int));
+    output = malloc(array_size * sizeof(int));
+    for (int i = 0; i < array_size; ++i) {
+        input[i] = rand() % 1000;
+    }
+    sort_input = malloc(sort_size * sizeof(int));
+    sorted = malloc(sort_size * sizeof(int));
+    for (int i = 0; i < sort_size; ++i) {
+        sort_input[i] = rand();
+    }
+    a = doubles(matrix_size * matrix_size);
+    b = doubles(matrix_size * matrix_size);
+    c = doubles(matrix_size * matrix_size);
+    particles.x = doubles(particle_count);
+    particles.y = doubles(particle_count);
+    particles.vx = doubles(particle_count);
+    particles.vy = doubles(particle_count);
+    particles.n = particle_count;
+}
+
+// each kernel runs the rhythm (rhythm = 1) or C version once and returns
+// the seconds taken. inputs are reset outside of the timed region
+static double copy(int rhythm) {
+    double start = now();
+    (rhythm ? rh_copy : c_copy)(input, input + array_size, output);
+    return now() - start;
+}
+
+static double sum(int rhythm) {
+    double start = now();
+    sink = (rhythm ? rh_sum : c_sum)(input, input + array_size);
+    return now() - start;
+}
+
+static double sort(int rhythm) {
+    memcpy(sorted, sort_input, sort_size * sizeof(int));
+    double start = now();
+    (rhythm ? rh_sort : c_sort)(sorted, sorted + sort_size);
+    return now() - start;
+}
+
+static double matmul(int rhythm) {
+    double start = now();
+    (rhythm ? rh_matmul : c_matmul)(a, b, c, matrix_size);
+    return now() - start;
+}
+
+static double advance(int rhythm) {
+    double start = now();
+    (rhythm ? rh_advance : c_advance)(&particles, 0.01);
+    return now() - start;
+}
+
+static int same(const double* x, const double* y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (fabs(x[i] - y[i]) > 1e-9 * fabs(y[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static double* saved(const double* p, size_t n) {
+    double* s = malloc(n * sizeof(double));
+    memcpy(s, p, n * sizeof(double));
+    return s;
+}
+
+// run both versions of each kernel once and compare their results
+static int verify(void) {
+    int ok = 1;
+
+    memset(output, 0, array_size * sizeof(int));
+    rh_copy(input, input + array_size, output);
+    ok &= memcmp(input, output, array_size * sizeof(int)) == 0;
+
+    ok &= rh_sum(input, input + array_size) == c_sum(input, input + array_size);
+
+    sort(1);
+    int* rh_sorted = malloc(sort_size * sizeof(int));
+    memcpy(rh_sorted, sorted, sort_size * sizeof(int));
+    sort(0);
+    ok &= memcmp(rh_sorted, sorted, sort_size * sizeof(int)) == 0;
+    free(rh_sorted);
+
+    rh_matmul(a, b, c, matrix_size);
+    double* rh_c = saved(c, matrix_size * matrix_size);
+    c_matmul(a, b, c, matrix_size);
+    ok &= same(rh_c, c, matrix_size * matrix_size);
+    free(rh_c);
+
+    double* x = saved(particles.x, particle_count);
+    double* y = saved(particles.y, particle_count);
+    rh_advance(&particles, 0.01);
+    double* rh_x = saved(particles.x, particle_count);
+    double* rh_y = saved(particles.y, particle_count);
+    memcpy(particles.x, x, particle_count * sizeof(double));
+    memcpy(particles.y, y, particle_count * sizeof(double));
+    c_advance(&particles, 0.01);
+    ok &= same(rh_x, particles.x, particle_count) && same(rh_y, particles.y, particle_count);
+    free(x);
+    free(y);
+    free(rh_x);
+    free(rh_y);
+
+    return ok;
+}
+
+static double best(double (*kernel)(int), int rhythm) {
+    double t = kernel(rhythm);
+    for (int i = 1; i < repetitions; ++i) {
+        double next = kernel(rhythm);
+        t = next < t ? next : t;
+    }
+    return t;
+}
+
+int main(int argc, char** argv) {
+    double threshold = argc > 1 ? atof(argv[1]) : 1.25;
+
+    const struct {
+        const char* name;
+        double (*kernel)(int);
+        double elements;
+    } kernels[] = {
+        { "copy",    copy,    array_size },
+        { "sum",     sum,     array_size },
+        { "sort",    sort,    sort_size },
+        { "matmul",  matmul,  (double)matrix_size * matrix_size * matrix_size },
+        { "advance", advance, particle_count },
+    };
+
+    setup();
+    if (!verify()) {
+        fprintf(stderr, "rhythm and C kernels disagree\n");
+        return 2;
+    }
+
+    printf("%-8s %14s %10s %7s\n", "kernel", "rhythm_ns/el", "c_ns/el", "ratio");
+    for (size_t i = 0; i < sizeof kernels / sizeof kernels[0]; ++i) {
+        double rh = best(kernels[i].kernel, 1) * 1e9 / kernels[i].elements;
+        double ref = best(kernels[i].kernel, 0) * 1e9 / kernels[i].elements;
+        printf("%-8s %14.3f %10.3f %7.2f%s\n", kernels[i].name, rh, ref, rh / ref,
+               rh / ref > threshold ? "  <-- slower than C" : "");
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+// C versions of the kernels in kernels.rh, written the same way so that the
+// difference in run time is the difference in code generation
+#include "kernels.h"
+
+int* c_copy(int* f_i, int* l_i, int* f_o) {
+    while (f_i < l_i) {
+        *f_o++ = *f_i++;
+    }
+    return f_o;
+}
+
+int c_sum(int* f, int* l) {
+    int acc = 0;
+    while (f < l) {
+        acc += *f++;
+    }
+    return acc;
+}
+
+void c_sort(int* f, int* l) {
+    for (int* i = f + 1; i < l; ++i) {
+        int v = *i;
+        int* j = i;
+        while (j > f && *(j - 1) > v) {
+            *j = *(j - 1);
+            --j;
+        }
+        *j = v;
+    }
+}
+
+void c_matmul(double* a, double* b, double* c, int n) {
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            double acc = 0.0;
+            for (int k = 0; k < n; ++k) {
+                acc += a[i * n + k] * b[k * n + j];
+            }
+            c[i * n + j] = acc;
+        }
+    }
+}
+
+void c_advance(struct particles* p, double dt) {
+    for (int i = 0; i < p->n; ++i) {
+        p->x[i] += p->vx[i] * dt;
+        p->y[i] += p->vy[i] * dt;
+    }
+}
@@ -0,0 +1,97 @@
+#!/bin/bash
+
+# compile time benchmarks. generates large synthetic programs (bench/generate.sh),
+# compiles each one several times and reports the median wall time, throughput
+# in source lines per second, peak memory and the median time of the parse,
+# check (TypeSystem) and emit (ir_emitter) phases.
+# with -b, exits with status 1 if throughput fell more than -t percent below
+# a previous run's results (e.g. a saved bench_output.txt)
+
+usage="usage: $0 [-r runs] [-O0|-O1|-O2|-O3] [-b baseline_file] [-t tolerance_percent]"
+
+runs=5
+opt_level="-O0"
+baseline=""
+tolerance=10
+rhythmc="${RHYTHMC:-./rhythmc}"
+bench_dir="$(dirname "$0")"
+output="bench_output.txt"
+
+while getopts "r:O:b:t:" opt; do
+    case $opt in
+        r) runs="$OPTARG" ;;
+        O) opt_level="-O$OPTARG" ;;
+        b) baseline="$OPTARG" ;;
+        t) tolerance="$OPTARG" ;;
+        *) echo $usage
+           exit 1 ;;
+    esac
+done
+
+# kind and size of each benchmark
+benchmarks=(
+    "procedures 5000"
+    "nesting 20000"
+    "overloads 1000"
+    "structs 2000"
+)
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+median() {
+    sort -g | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+# phase time in milliseconds from a --time-passes --stats=json report
+phase_ms() {
+    grep -o "\"$1\": [0-9.e+-]*" "$2" | awk '{ printf "%.3f\n", $2 * 1000 }'
+}
+
+counter() {
+    grep -o "\"$1\": [0-9]*" "$2" | awk '{ print $2 }'
+}
+
+printf "%-11s %7s %8s %11s %12s %11s %9s %9s %9s\n" \
+    benchmark size lines wall_ms lines_per_s peak_rss_kb parse_ms check_ms emit_ms | tee "$output"
+
+status=0
+for benchmark in "${benchmarks[@]}"; do
+    read kind size <<< "$benchmark"
+    src="$tmp/$kind.rh"
+    bash "$bench_dir/generate.sh" $kind $size > "$src"
+    lines=$(wc -l < "$src")
+
+    for ((run = 0; run < runs; run++)); do
+        start=$(date +%s%N)
+        if ! "$rhythmc" $opt_level --time-passes --stats=json "$src" > /dev/null 2> "$tmp/report.$run"; then
+            echo "$kind: rhythmc failed" >&2
+            cat "$tmp/report.$run" >&2
+            exit 1
+        fi
+        end=$(date +%s%N)
+        echo $(( (end - start) / 1000 )) >> "$tmp/wall_us"
+        phase_ms parse "$tmp/report.$run" >> "$tmp/parse"
+        phase_ms check "$tmp/report.$run" >> "$tmp/check"
+        phase_ms emit "$tmp/report.$run" >> "$tmp/emit"
+        counter peak_rss_kb "$tmp/report.$run" >> "$tmp/rss"
+    done
+
+    wall_us=$(median < "$tmp/wall_us")
+    lines_per_s=$(( lines * 1000000 / wall_us ))
+    printf "%-11s %7d %8d %11.1f %12d %11d %9.3f %9.3f %9.3f\n" \
+        $kind $size $lines $(awk "BEGIN { print $wall_us / 1000 }") $lines_per_s \
+        $(sort -n "$tmp/rss" | tail -1) $(median < "$tmp/parse") $(median < "$tmp/check") $(median < "$tmp/emit") \
+        | tee -a "$output"
+    rm -f "$tmp/wall_us" "$tmp/parse" "$tmp/check" "$tmp/emit" "$tmp/rss"
+
+    if [ -n "$baseline" ]; then
+        expected=$(awk -v k=$kind -v s=$size '$1 == k && $2 == s { print $5 }' "$baseline")
+        if [ -n "$expected" ] && [ $(( lines_per_s * 100 )) -lt $(( expected * (100 - tolerance) )) ]; then
+            echo "REGRESSION: $kind $lines_per_s lines/s, baseline $expected lines/s" >&2
+            status=1
+        fi
+    fi
+done
+
+exit $status
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# runtime benchmarks. builds the kernels in bench/kernels/kernels.rh and their
+# C references at each optimization level, then reports ns per element for
+# both and flags kernels where the rhythm version is more than -t times slower
+# (usually a sign that ir_emitter.cpp lowers something poorly)
+
+usage="usage: $0 [-t threshold] [-l \"levels\"]"
+
+threshold=1.25
+levels="0 1 2 3"
+rhythmc="${RHYTHMC:-./rhythmc}"
+cc="${CC:-cc}"
+kernels_dir="$(dirname "$0")/kernels"
+output="bench_runtime_output.txt"
+
+while getopts "t:l:" opt; do
+    case $opt in
+        t) threshold="$OPTARG" ;;
+        l) levels="$OPTARG" ;;
+        *) echo $usage
+           exit 1 ;;
+    esac
+done
+
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# the driver is always optimized so that only the kernels vary
+$cc -O2 -c "$kernels_dir/main.c" -o "$tmp/main.o" || exit 1
+
+: > "$output"
+for level in $levels; do
+    "$rhythmc" -O$level -c "$kernels_dir/kernels.rh" -o "$tmp/kernels.o" || exit 1
+    $cc -O$level -c "$kernels_dir/reference.c" -o "$tmp/reference.o" || exit 1
+    $cc -o "$tmp/kernels" "$tmp/main.o" "$tmp/kernels.o" "$tmp/reference.o" -lm || exit 1
+
+    echo "-O$level" | tee -a "$output"
+    "$tmp/kernels" $threshold | tee -a "$output"
+    status=${PIPESTATUS[0]}
+    if [ $status -ne 0 ]; then
+        exit $status
+    fi
+    echo | tee -a "$output"
+done
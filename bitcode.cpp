@@ -0,0 +1,64 @@
+#include "bitcode.hpp"
+#include <iostream>
+#include <optional>
+#include "llvm/Analysis/ModuleSummaryAnalysis.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SystemUtils.h"
+#include "llvm/Support/raw_ostream.h"
+
+static bool error(const std::string& str) {
+    std::cerr << str << std::endl;
+    return false;
+}
+
+bool write_bitcode(const llvm::Module& m, const std::string& path, bool thin_lto) {
+    std::optional<llvm::ModuleSummaryIndex> index;
+    if (thin_lto) {
+        llvm::ProfileSummaryInfo psi(m);
+        index.emplace(llvm::buildModuleSummaryIndex(m, nullptr, &psi));
+    }
+    const llvm::ModuleSummaryIndex* summary = index ? &*index : nullptr;
+
+    if (path == "-") {
+        // refuses (with a warning) to print binary to a terminal
+        if (llvm::CheckBitcodeOutputToConsole(llvm::outs())) {
+            return false;
+        }
+        llvm::WriteBitcodeToFile(m, llvm::outs(), false, summary);
+        llvm::outs().flush();
+        return true;
+    }
+
+    std::error_code ec;
+    llvm::raw_fd_ostream os(path, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+        return error("could not open " + path + ": " + ec.message());
+    }
+    llvm::WriteBitcodeToFile(m, os, false, summary);
+    return true;
+}
+
+bool link_bitcode(llvm::Module& m, const std::vector<std::string>& paths) {
+    llvm::Linker linker(m);
+    for (const std::string& path : paths) {
+        auto buffer = llvm::MemoryBuffer::getFileOrSTDIN(path);
+        if (!buffer) {
+            return error("could not open " + path + ": " + buffer.getError().message());
+        }
+        auto input = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), m.getContext());
+        if (!input) {
+            llvm::logAllUnhandledErrors(input.takeError(), llvm::errs(), path + ": ");
+            return false;
+        }
+        if (linker.linkInModule(std::move(*input))) {
+            return error("could not link " + path);
+        }
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#ifndef BITCODE_HPP
+#define BITCODE_HPP
+
+#include <string>
+#include <vector>
+#include "llvm/IR/Module.h"
+
+// write the module as LLVM bitcode to path, or to standard output for "-"
+// (unless that is a terminal). with thin_lto, the bitcode carries a ThinLTO
+// summary of the module's procedures (what each calls and references, see
+// link_thin_lto). returns false (and says why) on failure
+bool write_bitcode(const llvm::Module& m, const std::string& path, bool thin_lto = false);
+
+// read each bitcode file into m's context and link it into m, in order.
+// returns false (and says why) if a file can't be read or linked
+bool link_bitcode(llvm::Module& m, const std::vector<std::string>& paths);
+
+#endif
\ No newline at end of file
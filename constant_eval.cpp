@@ -0,0 +1,555 @@
+#include "constant_eval.hpp"
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include "overloads.hpp"
+#include "symbol_table.hpp"
+
+using namespace TypeSystem;
+
+namespace {
+
+// evaluation gives up after this many expressions, so that a loop that never
+// ends is reported instead of hanging the compiler
+constexpr size_t max_steps = 10'000'000;
+constexpr size_t max_depth = 1'000;
+
+bool is_scalar(TypeRef t) {
+    return is_integral(t) || is_floating_point(t) || t == Intrinsics::boolean;
+}
+
+// wrap v to the width of t, then sign or zero extend it back to 64 bits
+Constant make_integer(TypeRef t, int64_t v) {
+    size_t bits = t == Intrinsics::boolean ? 1 : 8 * size_of(t);
+    if (bits < 64) {
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        uint64_t u = uint64_t(v) & mask;
+        if (is_signed_integral(t) && ((u >> (bits - 1)) & 1)) {
+            u |= ~mask;
+        }
+        v = int64_t(u);
+    }
+    Constant c{t};
+    c.integer = v;
+    return c;
+}
+
+Constant make_real(TypeRef t, double v) {
+    Constant c{t};
+    c.real = t == Intrinsics::float32 ? double(float(v)) : v;
+    return c;
+}
+
+Constant make_bool(bool b) {
+    return make_integer(Intrinsics::boolean, b);
+}
+
+// the value of c as a value of type t, for assignments and initializers.
+// integers convert between types of any width, like the stores they become
+std::optional<Constant> convert(const Constant& c, TypeRef t) {
+    if (c.type == t) {
+        return c;
+    }
+    if (is_integral(c.type) && is_integral(t)) {
+        return make_integer(t, c.integer);
+    }
+    return std::nullopt;
+}
+
+// the operators intrinsic_op implements. the evaluator runs before the type
+// checker has annotated size expressions, so it goes by the operands' values
+// rather than is_intrinsic_op
+bool is_operator(const std::string& name) {
+    static const std::set<std::string> operators{"+", "-", "*", "/", "%", "=", "!=", "<", "<=", ">", ">="};
+    return operators.count(name);
+}
+
+enum class Flow { next, returned, failed };
+
+struct Evaluator {
+    std::string why;
+    size_t steps = 0;
+    size_t depth = 0;
+
+    // the variables of one procedure call
+    struct Frame {
+        SymbolTable<Variable, Constant> variables;
+        // owns the values the table points to
+        std::deque<Constant> values;
+        std::optional<Constant> result;
+    };
+    Frame* frame = nullptr;
+
+    std::nullopt_t fail(const std::string& reason) {
+        if (why.empty()) {
+            why = reason;
+        }
+        return std::nullopt;
+    }
+
+    // expressions
+    // -----------
+    std::optional<Constant> value(const Expression& expr) {
+        if (++steps > max_steps) {
+            return fail("evaluation did not finish after " + std::to_string(max_steps) + " steps");
+        }
+        if (auto lit = std::get_if<Literal>(&expr.value)) {
+            return value(*lit, expr.type);
+        }
+        return std::visit([this](const auto& x) { return value(x); }, expr.value);
+    }
+
+    // a literal of the type it is annotated with, e.g. a folded constant
+    std::optional<Constant> value(const Literal& lit, TypeRef annotated) {
+        switch (lit.type) {
+        case Literal::Type::integer: {
+            TypeRef t = annotated && is_scalar(annotated) ? annotated : Intrinsics::integer;
+            return make_integer(t, is_unsigned_integral(t) ? int64_t(std::stoull(lit.value)) : std::stoll(lit.value));
+        }
+        case Literal::Type::rational: {
+            TypeRef t = annotated && is_floating_point(annotated) ? annotated : Intrinsics::float64;
+            return make_real(t, std::strtod(lit.value.c_str(), nullptr));
+        }
+        default:
+            return fail("strings are not constants");
+        }
+    }
+
+    std::optional<Constant> value(const Literal& lit) {
+        return value(lit, nullptr);
+    }
+
+    std::optional<Constant> value(const Variable& var) {
+        if (Constant* c = frame ? frame->variables.find(var) : nullptr) {
+            return *c;
+        }
+        // a let variable of a scalar type, once the type checker resolved it
+        const Declaration* decl = var.declaration;
+        if (decl && decl->constant && decl->initializer && is_scalar(intern(decl->type))) {
+            std::string reason;
+            auto elements = evaluate_initializer(*decl->initializer, intern(decl->type), &reason);
+            if (!elements) {
+                return fail(reason);
+            }
+            return elements->front();
+        }
+        return fail("`" + var.name + "` is not a constant");
+    }
+
+    std::optional<Constant> value(const TypeCast& cast) {
+        std::optional<Constant> v = value(*cast.expr);
+        if (!v) {
+            return std::nullopt;
+        }
+        TypeRef from = v->type;
+        TypeRef to = intern(cast.type);
+        if (is_integral(from) && is_integral(to)) {
+            return make_integer(to, v->integer);
+        }
+        if (is_integral(from) && is_floating_point(to)) {
+            return make_real(to, is_signed_integral(from) ? double(v->integer) : double(uint64_t(v->integer)));
+        }
+        if (is_floating_point(from) && is_floating_point(to)) {
+            return make_real(to, v->real);
+        }
+        if (is_floating_point(from) && is_integral(to)) {
+            // out of range conversions have no defined value
+            double limit = is_signed_integral(to) ? 0x1p63 : 0x1p64;
+            double lowest = is_signed_integral(to) ? -0x1p63 : -1.0;
+            if (!(v->real > lowest && v->real < limit)) {
+                return fail("`" + std::to_string(v->real) + "` does not fit in `" + to->mangled + "`");
+            }
+            return make_integer(to, is_signed_integral(to) ? int64_t(v->real) : int64_t(uint64_t(v->real)));
+        }
+        return fail("can't convert `" + from->mangled + "` to `" + to->mangled + "` at compile time");
+    }
+
+    std::optional<Constant> value(const Invocation& invoc) {
+        const std::string& name = invoc.name;
+        if (name == "<-") {
+            return assign(invoc);
+        }
+        if (name == "&&" || name == "||") {
+            std::optional<Constant> lhs = value(invoc.args.front());
+            if (!lhs || lhs->type != Intrinsics::boolean) {
+                return lhs ? fail("`" + name + "` expects Bool operands") : std::nullopt;
+            }
+            // the rhs is only evaluated if the lhs does not decide the result
+            if (bool(lhs->integer) == (name == "||")) {
+                return lhs;
+            }
+            return value(invoc.args.back());
+        }
+        if (name == "successor" && invoc.args.size() == 1) {
+            std::optional<Constant> v = value(invoc.args.front());
+            if (v && !is_integral(v->type)) {
+                return fail("`successor` is only a constant for integers");
+            }
+            return v ? std::optional(make_integer(v->type, int64_t(uint64_t(v->integer) + 1))) : std::nullopt;
+        }
+        if (is_operator(name)) {
+            if (invoc.args.size() == 1) {
+                std::optional<Constant> v = value(invoc.args.front());
+                return v ? negate(*v) : std::nullopt;
+            }
+            std::optional<Constant> lhs = value(invoc.args.front());
+            std::optional<Constant> rhs = lhs ? value(invoc.args.back()) : std::nullopt;
+            return rhs ? binary_op(name, *lhs, *rhs) : std::nullopt;
+        }
+        return call(invoc);
+    }
+
+    std::optional<Constant> assign(const Invocation& invoc) {
+        auto var = std::get_if<Variable>(&invoc.args.front().value);
+        Constant* target = var && frame ? frame->variables.find(*var) : nullptr;
+        if (!target) {
+            return fail("only local variables can be assigned at compile time");
+        }
+        std::optional<Constant> v = value(invoc.args.back());
+        if (!v) {
+            return std::nullopt;
+        }
+        std::optional<Constant> converted = convert(*v, target->type);
+        if (!converted) {
+            return fail("can't assign `" + v->type->mangled + "` to `" + var->name + "`");
+        }
+        *target = *converted;
+        return converted;
+    }
+
+    std::optional<Constant> negate(const Constant& v) {
+        if (is_integral(v.type)) {
+            return make_integer(v.type, int64_t(0 - uint64_t(v.integer)));
+        }
+        if (is_floating_point(v.type)) {
+            return make_real(v.type, -v.real);
+        }
+        return fail("can't negate `" + v.type->mangled + "`");
+    }
+
+    // as intrinsic_op emits them: the lhs decides the type, comparisons of
+    // floating point numbers are unordered (true if either is NaN)
+    std::optional<Constant> binary_op(const std::string& op, const Constant& lhs, const Constant& rhs_value) {
+        TypeRef t = lhs.type;
+        std::optional<Constant> converted = convert(rhs_value, t);
+        if (!converted || !is_scalar(t)) {
+            return fail("can't apply `" + op + "` to `" + lhs.type->mangled + "` and `"
+                        + rhs_value.type->mangled + "` at compile time");
+        }
+        const Constant& rhs = *converted;
+
+        if (is_floating_point(t)) {
+            double a = lhs.real;
+            double b = rhs.real;
+            bool unordered = std::isnan(a) || std::isnan(b);
+            if (op == "+") return make_real(t, a + b);
+            if (op == "-") return make_real(t, a - b);
+            if (op == "*") return make_real(t, a * b);
+            if (op == "/") return make_real(t, a / b);
+            if (op == "%") return make_real(t, std::fmod(a, b));
+            if (op == "=")  return make_bool(unordered || a == b);
+            if (op == "!=") return make_bool(unordered || a != b);
+            if (op == "<")  return make_bool(unordered || a < b);
+            if (op == "<=") return make_bool(unordered || a <= b);
+            if (op == ">")  return make_bool(unordered || a > b);
+            if (op == ">=") return make_bool(unordered || a >= b);
+            return fail("unknown operator `" + op + "`");
+        }
+
+        // unsigned values and Bools are zero extended, so they compare and divide as uint64_t
+        bool is_signed = is_signed_integral(t);
+        int64_t a = lhs.integer;
+        int64_t b = rhs.integer;
+        uint64_t ua = uint64_t(a);
+        uint64_t ub = uint64_t(b);
+        if (op == "+") return make_integer(t, int64_t(ua + ub));
+        if (op == "-") return make_integer(t, int64_t(ua - ub));
+        if (op == "*") return make_integer(t, int64_t(ua * ub));
+        if (op == "/" || op == "%") {
+            if (b == 0) {
+                return fail("division by zero");
+            }
+            if (is_signed && a == std::numeric_limits<int64_t>::min() && b == -1) {
+                return fail("signed division overflows");
+            }
+            if (op == "/") {
+                return make_integer(t, is_signed ? a / b : int64_t(ua / ub));
+            }
+            return make_integer(t, is_signed ? a % b : int64_t(ua % ub));
+        }
+        if (op == "=")  return make_bool(a == b);
+        if (op == "!=") return make_bool(a != b);
+        if (op == "<")  return make_bool(is_signed ? a <  b : ua <  ub);
+        if (op == "<=") return make_bool(is_signed ? a <= b : ua <= ub);
+        if (op == ">")  return make_bool(is_signed ? a >  b : ua >  ub);
+        if (op == ">=") return make_bool(is_signed ? a >= b : ua >= ub);
+        return fail("unknown operator `" + op + "`");
+    }
+
+    // the overload called with the arguments' types, if it is constexpr
+    const Procedure* resolve(const std::string& name, const std::vector<Constant>& args) {
+        std::vector<TypeRef> arg_types;
+        for (const Constant& arg : args) {
+            arg_types.push_back(arg.type);
+        }
+        const Procedure* proc = resolve_overload(name, arg_types);
+        return proc && (proc->attributes & Procedure::constant) ? proc : nullptr;
+    }
+
+    std::optional<Constant> call(const Invocation& invoc) {
+        std::vector<Constant> args;
+        for (const Expression& arg : invoc.args) {
+            std::optional<Constant> v = value(arg);
+            if (!v) {
+                return std::nullopt;
+            }
+            args.push_back(*v);
+        }
+        const Procedure* proc = resolve(invoc.name, args);
+        if (!proc) {
+            return fail("`" + invoc.name + "` is not a constexpr procedure");
+        }
+        if (!proc->symbol.empty()) {
+            return fail("the body of `" + invoc.name + "` is not available, it was imported from an interface");
+        }
+        if (depth == max_depth) {
+            return fail("calls nested more than " + std::to_string(max_depth) + " deep");
+        }
+
+        Frame callee;
+        callee.variables.push_frame();
+        for (size_t i = 0; i < args.size(); ++i) {
+            callee.values.push_back(args[i]);
+            callee.variables.add(proc->parameters[i].variable, &callee.values.back());
+        }
+        Frame* caller = frame;
+        frame = &callee;
+        ++depth;
+        Flow flow = run_current_frame(proc->block);
+        --depth;
+        frame = caller;
+
+        if (flow == Flow::failed) {
+            return std::nullopt;
+        }
+        if (!callee.result) {
+            return fail("`" + invoc.name + "` does not return a value");
+        }
+        return callee.result;
+    }
+
+    // statements
+    // ----------
+    Flow run(const Statement& stmt) {
+        return std::visit([this](const auto& x) { return run(x); }, stmt.value);
+    }
+
+    Flow run_current_frame(const Block& block) {
+        for (const Statement& stmt : block.statements) {
+            Flow flow = run(stmt);
+            if (flow != Flow::next) {
+                return flow;
+            }
+        }
+        return Flow::next;
+    }
+
+    Flow run(const Block& block) {
+        frame->variables.push_frame();
+        Flow flow = run_current_frame(block);
+        frame->variables.pop_frame();
+        return flow;
+    }
+
+    Flow run(const Expression& expr) {
+        return value(expr) ? Flow::next : Flow::failed;
+    }
+
+    Flow run(const Declaration& decl) {
+        TypeRef t = intern(decl.type);
+        if (!is_scalar(t)) {
+            fail("`" + decl.variable.name + "` is not a number or Bool");
+            return Flow::failed;
+        }
+        Constant c = is_floating_point(t) ? make_real(t, 0.0) : make_integer(t, 0);
+        if (decl.initializer) {
+            std::optional<Constant> v = value(*decl.initializer);
+            std::optional<Constant> converted = v ? convert(*v, t) : std::nullopt;
+            if (!converted) {
+                if (v) {
+                    fail("can't initialize `" + decl.variable.name + "` with `" + v->type->mangled + "`");
+                }
+                return Flow::failed;
+            }
+            c = *converted;
+        }
+        frame->values.push_back(c);
+        frame->variables.add(decl.variable, &frame->values.back());
+        return Flow::next;
+    }
+
+    // true, false or failed
+    std::optional<bool> condition(const Expression& expr) {
+        std::optional<Constant> v = value(expr);
+        if (v && v->type != Intrinsics::boolean) {
+            fail("conditions must be Bools");
+            return std::nullopt;
+        }
+        return v ? std::optional(v->integer != 0) : std::nullopt;
+    }
+
+    Flow run(const Conditional& cond) {
+        std::optional<bool> taken = condition(cond.condition);
+        if (!taken) {
+            return Flow::failed;
+        }
+        return run(*taken ? cond.then_block : cond.else_block);
+    }
+
+    Flow run(const WhileLoop& loop) {
+        while (true) {
+            std::optional<bool> taken = condition(loop.condition);
+            if (!taken) {
+                return Flow::failed;
+            }
+            if (!*taken) {
+                return Flow::next;
+            }
+            Flow flow = run(loop.block);
+            if (flow != Flow::next) {
+                return flow;
+            }
+        }
+    }
+
+    Flow run(const Return& ret) {
+        if (ret.value) {
+            frame->result = value(*ret.value);
+            if (!frame->result) {
+                return Flow::failed;
+            }
+        }
+        return Flow::returned;
+    }
+
+    Flow run(const Import&) {
+        fail("imports are not evaluated at compile time");
+        return Flow::failed;
+    }
+
+    Flow run(const Procedure&) {
+        fail("procedures are not defined at compile time");
+        return Flow::failed;
+    }
+
+    Flow run(const Typedef&) {
+        fail("typedefs are not evaluated at compile time");
+        return Flow::failed;
+    }
+};
+
+}
+
+std::optional<Constant> evaluate(const Expression& expr, std::string* why) {
+    Evaluator evaluator;
+    std::optional<Constant> c = evaluator.value(expr);
+    if (!c && why) {
+        *why = evaluator.why;
+    }
+    return c;
+}
+
+static bool initializer_elements(const Expression& init, TypeRef type, std::vector<Constant>& elements,
+                                 std::string& why) {
+    if (is_array(type)) {
+        auto literal = std::get_if<Invocation>(&init.value);
+        if (!literal || literal->name != "[]") {
+            why = "`" + type->mangled + "` is initialized with an array literal `[a, b, ...]`";
+            return false;
+        }
+        if (literal->args.size() != type->num_elements) {
+            why = "`" + type->mangled + "` has " + std::to_string(type->num_elements) + " elements, not "
+                + std::to_string(literal->args.size());
+            return false;
+        }
+        for (const Expression& element : literal->args) {
+            if (!initializer_elements(element, type->value_type, elements, why)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!is_scalar(type)) {
+        why = "only numbers, Bools and arrays of them are constant data, not `" + type->mangled + "`";
+        return false;
+    }
+
+    std::optional<Constant> c = evaluate(init, &why);
+    if (!c) {
+        return false;
+    }
+    std::optional<Constant> converted = is_floating_point(c->type) && is_floating_point(type)
+        ? make_real(type, c->real)
+        : convert(*c, type);
+    if (!converted) {
+        why = "can't initialize `" + type->mangled + "` with `" + c->type->mangled + "`";
+        return false;
+    }
+    elements.push_back(*converted);
+    return true;
+}
+
+std::optional<std::vector<Constant>> evaluate_initializer(const Expression& init, TypeRef type, std::string* why) {
+    std::vector<Constant> elements;
+    std::string reason;
+    if (!initializer_elements(init, type, elements, reason)) {
+        if (why) {
+            *why = reason;
+        }
+        return std::nullopt;
+    }
+    return elements;
+}
+
+std::optional<size_t> constant_size(const Expression& expr, std::string* why) {
+    // types are interned from every emitter thread, and evaluating a size may
+    // intern types with sizes of their own
+    static std::recursive_mutex mutex;
+    static std::unordered_map<const Expression*, std::pair<std::optional<size_t>, std::string>> sizes;
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+
+    auto [it, inserted] = sizes.try_emplace(&expr);
+    auto& [size, reason] = it->second;
+    if (inserted) {
+        std::optional<Constant> c = evaluate(expr, &reason);
+        if (c && !is_integral(c->type)) {
+            reason = "sizes must be integers, not `" + c->type->mangled + "`";
+        }
+        else if (c && is_signed_integral(c->type) && c->integer < 0) {
+            reason = "sizes can't be negative";
+        }
+        else if (c) {
+            size = size_t(c->integer);
+        }
+    }
+    if (!size && why) {
+        *why = reason;
+    }
+    return size;
+}
+
+std::string to_literal(const Constant& c) {
+    if (is_floating_point(c.type)) {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.17g", c.real);
+        return text;
+    }
+    if (is_unsigned_integral(c.type) || c.type == Intrinsics::boolean) {
+        return std::to_string(uint64_t(c.integer));
+    }
+    return std::to_string(c.integer);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef CONSTANT_EVAL_HPP
+#define CONSTANT_EVAL_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "parse_tree.hpp"
+#include "type_system.hpp"
+
+// a value computed at compile time. integers are kept sign or zero extended
+// to 64 bits according to their type, Bools are 0 or 1
+struct Constant {
+    TypeSystem::TypeRef type;
+    int64_t integer = 0;
+    double real = 0.0;
+};
+
+// evaluate an expression at compile time by interpreting the parse tree.
+// constants are literals, casts and intrinsic ops of constants, and calls of
+// `constexpr` procedures with constant arguments. the procedures may declare
+// and assign variables, branch, loop and call other constexpr procedures, but
+// not touch memory (pointers, arrays, structs) or call anything else.
+// returns nullopt if the expression is not constant, and then sets `why`
+std::optional<Constant> evaluate(const Expression& expr, std::string* why = nullptr);
+
+// the value of a constant size parameter (e.g. `Array(Int, (4 * n()))`),
+// evaluated once per expression. returns nullopt if it is not a constant,
+// non-negative integer, and then sets `why`
+std::optional<size_t> constant_size(const Expression& expr, std::string* why = nullptr);
+
+// the data a global or `let` variable of type `type` is initialized with, its
+// scalars in memory order: a constant converted to a scalar type (floating
+// point numbers are rounded to its precision), or for an array, an array
+// literal `[a, b, ...]` with an initializer for each element. returns nullopt
+// if the initializer is not constant, and then sets `why`
+std::optional<std::vector<Constant>> evaluate_initializer(const Expression& init, TypeSystem::TypeRef type,
+                                                          std::string* why = nullptr);
+
+// the literal text of a constant, as the emitter reads it back for a literal
+// annotated with the constant's type
+std::string to_literal(const Constant& c);
+
+#endif
\ No newline at end of file
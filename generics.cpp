@@ -0,0 +1,248 @@
+#include "generics.hpp"
+#include <algorithm>
+#include <map>
+#include "arena.hpp"
+#include "constant_eval.hpp"
+
+using namespace TypeSystem;
+
+std::vector<Procedure*> procedure_instances;
+
+// by linkage name
+static std::map<std::string, const Procedure*> instances;
+
+// deduction
+// ---------
+using Bindings = std::map<std::string, TypeRef>;
+
+static bool is_parameter(const Procedure& generic, const std::string& name) {
+    const auto& params = generic.type_parameters;
+    return std::find(params.begin(), params.end(), name) != params.end();
+}
+
+static bool mentions_parameter(const Procedure& generic, const Type& t) {
+    if (t.parameters.empty()) {
+        return is_parameter(generic, t.name);
+    }
+    return std::any_of(t.parameters.begin(), t.parameters.end(), [&generic](const auto& param) {
+        if (auto p = std::get_if<Type>(&param)) {
+            return mentions_parameter(generic, *p);
+        }
+        if (auto decl = std::get_if<Declaration>(&param)) {
+            return mentions_parameter(generic, decl->type);
+        }
+        return false;
+    });
+}
+
+static std::optional<size_t> size_parameter(const std::variant<Type, size_t, Declaration, Expression*>& param) {
+    if (auto sz = std::get_if<size_t>(&param)) {
+        return *sz;
+    }
+    if (auto expr = std::get_if<Expression*>(&param)) {
+        return constant_size(**expr);
+    }
+    return std::nullopt;
+}
+
+// match the parameter type `pattern` against an argument type, binding the
+// type parameters it mentions
+static bool deduce(const Procedure& generic, const Type& pattern, TypeRef actual, Bindings& bindings) {
+    if (!mentions_parameter(generic, pattern)) {
+        return intern(pattern) == actual;
+    }
+    if (pattern.parameters.empty()) {
+        auto [it, inserted] = bindings.emplace(pattern.name, actual);
+        return inserted || it->second == actual;
+    }
+    // a constructed type, e.g. Pointer(T), only matches one of the same constructor
+    if (pattern.name != actual->name) {
+        return false;
+    }
+    if (pattern.name == Intrinsics::pointer) {
+        return pattern.parameters.size() == 1
+            && std::holds_alternative<Type>(pattern.parameters[0])
+            && deduce(generic, std::get<Type>(pattern.parameters[0]), actual->value_type, bindings);
+    }
+    if (pattern.name == Intrinsics::array || pattern.name == Intrinsics::vector) {
+        return pattern.parameters.size() == 2
+            && std::holds_alternative<Type>(pattern.parameters[0])
+            && size_parameter(pattern.parameters[1]) == actual->num_elements
+            && deduce(generic, std::get<Type>(pattern.parameters[0]), actual->value_type, bindings);
+    }
+    if (pattern.name == Intrinsics::structure) {
+        if (pattern.parameters.size() != actual->fields.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < actual->fields.size(); ++i) {
+            auto decl = std::get_if<Declaration>(&pattern.parameters[i]);
+            if (!decl || decl->variable.name != actual->fields[i].first
+                || !deduce(generic, decl->type, actual->fields[i].second, bindings)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// the type as it would be written in the source
+static Type to_type(TypeRef t) {
+    if (t->name == Intrinsics::pointer) {
+        return Type{t->name, { to_type(t->value_type) }};
+    }
+    if (t->name == Intrinsics::array || t->name == Intrinsics::vector) {
+        return Type{t->name, { to_type(t->value_type), t->num_elements }};
+    }
+    if (t->name == Intrinsics::structure) {
+        Type s{t->name};
+        for (const auto& [name, field_type] : t->fields) {
+            s.parameters.push_back(Declaration{Variable{name, intern_identifier(name)}, to_type(field_type)});
+        }
+        return s;
+    }
+    // intrinsic and typedef'd types are known by name
+    return Type{t->name};
+}
+
+// substitution
+// ------------
+// replaces the type parameters in a copy of the generic's body. casts and
+// size expressions point into the arena, so they are copied too
+struct Substitution {
+    std::map<std::string, Type> types;
+
+    void apply(Type& t) {
+        if (t.parameters.empty()) {
+            if (auto it = types.find(t.name); it != types.end()) {
+                t = it->second;
+            }
+            return;
+        }
+        for (auto& param : t.parameters) {
+            if (auto p = std::get_if<Type>(&param)) {
+                apply(*p);
+            }
+            else if (auto decl = std::get_if<Declaration>(&param)) {
+                apply(decl->type);
+            }
+            else if (auto expr = std::get_if<Expression*>(&param)) {
+                *expr = parse_arena.make<Expression>(**expr);
+                apply(**expr);
+            }
+        }
+    }
+
+    void apply(Expression& expr) {
+        expr.type = nullptr;
+        std::visit([this](auto& x) { apply(x); }, expr.value);
+    }
+    void apply(Literal&) {}
+    void apply(Variable& var) {
+        var.declaration = nullptr;
+    }
+    void apply(Invocation& invoc) {
+        for (Expression& arg : invoc.args) {
+            apply(arg);
+        }
+    }
+    void apply(TypeCast& cast) {
+        apply(cast.type);
+        cast.expr = parse_arena.make<Expression>(*cast.expr);
+        apply(*cast.expr);
+    }
+
+    void apply(Statement& stmt) {
+        std::visit([this](auto& x) { apply(x); }, stmt.value);
+    }
+    void apply(Block& block) {
+        for (Statement& stmt : block.statements) {
+            apply(stmt);
+        }
+    }
+    void apply(Declaration& decl) {
+        apply(decl.type);
+        if (decl.initializer) {
+            apply(*decl.initializer);
+        }
+    }
+    void apply(Import&) {}
+    void apply(Conditional& cond) {
+        apply(cond.condition);
+        apply(cond.then_block);
+        apply(cond.else_block);
+    }
+    void apply(WhileLoop& loop) {
+        apply(loop.condition);
+        apply(loop.block);
+    }
+    void apply(Procedure& proc) {
+        for (Declaration& param : proc.parameters) {
+            apply(param);
+        }
+        apply(proc.return_type);
+        apply(proc.block);
+    }
+    void apply(Return& ret) {
+        if (ret.value) {
+            apply(*ret.value);
+        }
+    }
+    void apply(Typedef& def) {
+        apply(def.type);
+    }
+};
+
+// all type parameters, from all parameter types
+static std::optional<Bindings> deduce(const Procedure& generic, const std::vector<TypeRef>& arg_types) {
+    if (generic.parameters.size() != arg_types.size()) {
+        return std::nullopt;
+    }
+    Bindings bindings;
+    for (size_t i = 0; i < arg_types.size(); ++i) {
+        if (!deduce(generic, generic.parameters[i].type, arg_types[i], bindings)) {
+            return std::nullopt;
+        }
+    }
+    // e.g. a type parameter only used in the return type
+    if (bindings.size() != generic.type_parameters.size()) {
+        return std::nullopt;
+    }
+    return bindings;
+}
+
+// instantiation
+// -------------
+bool fits(const Procedure& generic, const std::vector<TypeRef>& arg_types) {
+    return deduce(generic, arg_types).has_value();
+}
+
+const Procedure* instantiate(const Procedure& generic, const std::vector<TypeRef>& arg_types) {
+    std::optional<Bindings> bindings = deduce(generic, arg_types);
+    if (!bindings) {
+        return nullptr;
+    }
+
+    // the parameter types of the instance are the argument types
+    std::string name = generic.name;
+    for (TypeRef t : arg_types) {
+        name += "_" + t->mangled;
+    }
+    if (auto it = instances.find(name); it != instances.end()) {
+        return it->second;
+    }
+
+    Procedure* instance = parse_arena.make<Procedure>(generic);
+    instance->type_parameters.clear();
+    // every module that calls it has its own copy
+    instance->attributes &= ~Procedure::exported;
+    Substitution substitution;
+    for (const auto& [param, type] : *bindings) {
+        substitution.types.emplace(param, to_type(type));
+    }
+    substitution.apply(*instance);
+
+    instances.emplace(name, instance);
+    procedure_instances.push_back(instance);
+    return instance;
+}
@@ -0,0 +1,31 @@
+#ifndef GENERICS_HPP
+#define GENERICS_HPP
+
+#include <string>
+#include <vector>
+#include "parse_tree.hpp"
+#include "type_system.hpp"
+
+// generic procedures are instantiated like C++ templates: a call whose
+// argument types match no ordinary overload (see overloads.hpp) deduces the
+// type parameters of a generic one from the argument types, e.g. T = Int for
+// `copy[T](f Pointer(T))` called with a Pointer(Int). the body is copied with
+// the parameters replaced by those types, and the copy is checked and emitted
+// like any procedure. ordinary overloads always win, so one for concrete types
+// specializes a generic procedure
+
+// instances made so far, in order. owned by the parse arena. the type
+// checker checks them as they are made, the emitters emit them after the
+// program's own procedures
+extern std::vector<Procedure*> procedure_instances;
+
+// whether the type parameters of `generic` can be deduced from these argument types
+bool fits(const Procedure& generic, const std::vector<TypeSystem::TypeRef>& arg_types);
+
+// the instance of `generic` for calls with these argument types, made on the
+// first such call. nullptr if the type parameters can't be deduced from them.
+// instances are keyed by their linkage name (see decorate_name), so every
+// call with the same argument types shares one
+const Procedure* instantiate(const Procedure& generic, const std::vector<TypeSystem::TypeRef>& arg_types);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "imports.hpp"
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "interface.hpp"
+
+// bison (yacc) setup, see main.cpp
+extern Block* program;
+extern int yyparse();
+extern void yyrestart(FILE* file);
+extern int line_num;
+
+// modules by real path, so each file is parsed once however it is named
+static std::map<std::string, Block*> modules;
+static std::vector<std::string> files;
+// where the interfaces of compiled modules are, empty to always parse
+static std::string interface_dir;
+
+const std::vector<std::string>& imported_files() {
+    return files;
+}
+
+static std::string real_path(const std::string& path) {
+    llvm::SmallString<256> real;
+    if (llvm::sys::fs::real_path(path, real)) {
+        return path;
+    }
+    return real.str().str();
+}
+
+static std::string resolve(const std::string& name, const std::string& importer_dir,
+                           const std::vector<std::string>& search_dirs) {
+    std::vector<std::string> dirs = { importer_dir };
+    dirs.insert(dirs.end(), search_dirs.begin(), search_dirs.end());
+    for (const std::string& dir : dirs) {
+        llvm::SmallString<256> path(dir);
+        llvm::sys::path::append(path, name + ".rh");
+        if (llvm::sys::fs::exists(path)) {
+            return path.str().str();
+        }
+    }
+    return "";
+}
+
+static Block* parse(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file) {
+        std::cerr << "could not open " << path << std::endl;
+        return nullptr;
+    }
+    Block* importer = program;
+    int importer_lines = line_num;
+    yyrestart(file);
+    line_num = 1;
+    bool parsed = yyparse() == 0;
+    fclose(file);
+
+    Block* module = program;
+    program = importer;
+    line_num = importer_lines;
+    if (!parsed) {
+        std::cerr << "could not parse " << path << std::endl;
+        return nullptr;
+    }
+    return module;
+}
+
+// a module's path below the interface directory, as rhythmc.sh lays it out:
+// relative to the current directory, with each leading .. replaced by __
+static std::string build_path(const std::string& path) {
+    llvm::SmallString<256> module, current;
+    if (llvm::sys::fs::real_path(path, module) || llvm::sys::fs::real_path(".", current)) {
+        return path;
+    }
+    auto m = llvm::sys::path::begin(module), m_end = llvm::sys::path::end(module);
+    auto c = llvm::sys::path::begin(current), c_end = llvm::sys::path::end(current);
+    while (m != m_end && c != c_end && *m == *c) {
+        ++m;
+        ++c;
+    }
+    llvm::SmallString<256> relative;
+    for (; c != c_end; ++c) {
+        llvm::sys::path::append(relative, "__");
+    }
+    for (; m != m_end; ++m) {
+        llvm::sys::path::append(relative, *m);
+    }
+    return relative.str().str();
+}
+
+// the module's interface if there is one, otherwise the parsed source. a
+// module's interface is interface_dir/<its build_path with .rhi for .rh>. it is
+// rewritten only when it changes, so its age says nothing about the source;
+// whoever passes the directory keeps the interfaces current
+static Block* read_module(const std::string& path) {
+    if (!interface_dir.empty()) {
+        llvm::SmallString<256> interface_path(interface_dir);
+        llvm::sys::path::append(interface_path, build_path(path));
+        llvm::sys::path::replace_extension(interface_path, "rhi");
+        if (llvm::sys::fs::exists(interface_path)) {
+            return read_interface(interface_path.str().str());
+        }
+    }
+    return parse(path);
+}
+
+static bool load(Block& block, const std::string& block_path, const std::vector<std::string>& search_dirs) {
+    // empty for the current directory
+    std::string dir = llvm::sys::path::parent_path(block_path).str();
+
+    for (Statement& stmt : block.statements) {
+        auto import = std::get_if<Import>(&stmt.value);
+        if (!import) {
+            continue;
+        }
+        std::string path = resolve(import->identifier, dir, search_dirs);
+        if (path.empty()) {
+            std::cerr << "could not find module " << import->identifier << " (" << block_path << ")" << std::endl;
+            return false;
+        }
+
+        auto [it, inserted] = modules.emplace(real_path(path), nullptr);
+        if (inserted) {
+            files.push_back(path);
+            it->second = read_module(path);
+            if (!it->second || !load(*it->second, path, search_dirs)) {
+                return false;
+            }
+        }
+        import->module = it->second;
+    }
+    return true;
+}
+
+bool load_imports(Block& program, const std::string& source_path,
+                  const std::vector<std::string>& search_dirs, const std::string& interfaces) {
+    interface_dir = interfaces;
+    modules[real_path(source_path)] = &program;
+    return load(program, source_path, search_dirs);
+}
\ No newline at end of file
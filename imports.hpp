@@ -0,0 +1,21 @@
+#ifndef IMPORTS_HPP
+#define IMPORTS_HPP
+
+#include <string>
+#include <vector>
+#include "parse_tree.hpp"
+
+// parse every module `program` imports, transitively. `import name` resolves
+// to name.rh in the importing file's directory, then in each search directory.
+// each Import statement is linked to its parsed module (Import::module).
+// with an interface directory, a module with an interface there is read from
+// the interface instead (see read_interface). the caller keeps them current,
+// as rhythmc.sh does by compiling a module before the modules importing it.
+// returns false (and says why) if a module can't be found or parsed
+bool load_imports(Block& program, const std::string& source_path,
+                  const std::vector<std::string>& search_dirs, const std::string& interface_dir = "");
+
+// paths of the imported modules, in the order they were loaded
+const std::vector<std::string>& imported_files();
+
+#endif
\ No newline at end of file
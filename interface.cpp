@@ -0,0 +1,359 @@
+#include "interface.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "arena.hpp"
+#include "ir_emitter.hpp"
+#include "type_system.hpp"
+
+// layout
+// ------
+// header, then the sections below in this order, each an array of records.
+// strings live in one string table and are referenced by offset and size,
+// types are trees of nodes whose children are listed in the children array.
+// all records are 4 or 8 byte aligned and sized, so every section is too
+namespace {
+
+const char magic[4] = { 'R', 'H', 'I', '\0' };
+// bump whenever the layout or the meaning of a record changes
+const uint32_t version = 2;
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t num_imports;
+    uint32_t num_typedefs;
+    uint32_t num_procedures;
+    uint32_t num_nodes;
+    uint32_t num_children;
+    uint32_t strings_size;
+};
+
+struct String {
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct TypedefRecord {
+    String name;
+    uint32_t type;
+    uint32_t padding;
+};
+
+// parameters are field nodes
+struct ProcedureRecord {
+    String name;
+    // linkage name, see decorate_name
+    String symbol;
+    uint32_t return_type;
+    uint32_t first_param;
+    uint32_t num_params;
+    uint32_t padding;
+};
+
+struct TypeNode {
+    enum Kind : uint32_t {
+        // name(children...), e.g. Pointer(Int)
+        type,
+        // an array size (value)
+        size,
+        // a named struct field or parameter: its index (value) and one child, its type
+        field,
+    };
+    uint32_t kind;
+    String name;
+    uint32_t first_child;
+    uint32_t num_children;
+    uint32_t padding;
+    uint64_t value;
+};
+
+}
+
+// writing
+// -------
+namespace {
+
+struct Writer {
+    std::vector<String> imports;
+    std::vector<TypedefRecord> typedefs;
+    std::vector<ProcedureRecord> procedures;
+    std::vector<TypeNode> nodes;
+    std::vector<uint32_t> children;
+    std::string strings;
+
+    String string(const std::string& s) {
+        String ref = { uint32_t(strings.size()), uint32_t(s.size()) };
+        strings += s;
+        return ref;
+    }
+
+    uint32_t node(TypeNode n) {
+        nodes.push_back(n);
+        return uint32_t(nodes.size() - 1);
+    }
+
+    // children of a node are added after all of them are written, so they are contiguous
+    uint32_t add_children(const std::vector<uint32_t>& kids) {
+        uint32_t first = uint32_t(children.size());
+        children.insert(children.end(), kids.begin(), kids.end());
+        return first;
+    }
+
+    uint32_t field(const Declaration& decl, size_t index) {
+        uint32_t child = type(decl.type);
+        return node({ TypeNode::field, string(decl.variable.name), add_children({ child }), 1, 0, index });
+    }
+
+    uint32_t type(const Type& t) {
+        std::vector<uint32_t> kids;
+        size_t field_index = 0;
+        for (const auto& param : t.parameters) {
+            if (auto p = std::get_if<Type>(&param)) {
+                kids.push_back(type(*p));
+            }
+            // the type checker folded constant size expressions
+            else if (auto n = std::get_if<size_t>(&param)) {
+                kids.push_back(node({ TypeNode::size, {0, 0}, 0, 0, 0, *n }));
+            }
+            else {
+                kids.push_back(field(std::get<Declaration>(param), field_index++));
+            }
+        }
+        return node({ TypeNode::type, string(t.name), add_children(kids), uint32_t(kids.size()), 0, 0 });
+    }
+
+    template<typename T>
+    static void append(std::string& out, const std::vector<T>& records) {
+        out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+    }
+
+    std::string contents() const {
+        Header header = {
+            { magic[0], magic[1], magic[2], magic[3] }, version,
+            uint32_t(imports.size()), uint32_t(typedefs.size()), uint32_t(procedures.size()),
+            uint32_t(nodes.size()), uint32_t(children.size()), uint32_t(strings.size())
+        };
+        std::string out(reinterpret_cast<const char*>(&header), sizeof(header));
+        append(out, imports);
+        append(out, typedefs);
+        append(out, procedures);
+        append(out, nodes);
+        append(out, children);
+        out += strings;
+        return out;
+    }
+};
+
+}
+
+bool write_interface(const Block& program, const std::string& path) {
+    Writer w;
+    for (const Statement& stmt : program.statements) {
+        if (auto import = std::get_if<Import>(&stmt.value)) {
+            w.imports.push_back(w.string(import->identifier));
+        }
+        else if (auto def = std::get_if<Typedef>(&stmt.value)) {
+            w.typedefs.push_back({ w.string(def->name), w.type(def->type), 0 });
+        }
+        // generic procedures are instantiated from their bodies, which an
+        // interface does not have, so only importing the source exports them
+        else if (auto proc = std::get_if<Procedure>(&stmt.value);
+                 proc && (proc->attributes & Procedure::exported) && proc->type_parameters.empty()) {
+            std::vector<uint32_t> params;
+            for (size_t i = 0; i < proc->parameters.size(); ++i) {
+                params.push_back(w.field(proc->parameters[i], i));
+            }
+            uint32_t return_type = w.type(proc->return_type);
+            w.procedures.push_back({ w.string(proc->name), w.string(decorate_name(*proc)), return_type,
+                                     w.add_children(params), uint32_t(params.size()), 0 });
+        }
+    }
+    std::string contents = w.contents();
+
+    if (auto old = llvm::MemoryBuffer::getFile(path); old && (*old)->getBuffer() == contents) {
+        return true;
+    }
+    // write aside and rename, so a concurrent import never reads half a file.
+    // the temporary file is unique, so concurrent writers don't clobber each other's
+    int fd;
+    llvm::SmallString<256> temp_path;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, temp_path)) {
+        std::cerr << "could not write " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    {
+        llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+        os << contents;
+    }
+    if (std::error_code ec = llvm::sys::fs::rename(temp_path, path)) {
+        llvm::sys::fs::remove(temp_path);
+        std::cerr << "could not write " << path << ": " << ec.message() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// reading
+// -------
+namespace {
+
+struct Reader {
+    const Header* header;
+    const String* imports;
+    const TypedefRecord* typedefs;
+    const ProcedureRecord* procedures;
+    const TypeNode* nodes;
+    const uint32_t* children;
+    const char* strings;
+
+    // sets up the sections, or returns false if the buffer is too small for them
+    bool map(llvm::StringRef buffer) {
+        const char* p = buffer.data();
+        const char* end = p + buffer.size();
+        if (buffer.size() < sizeof(Header)) {
+            return false;
+        }
+        header = reinterpret_cast<const Header*>(p);
+        if (std::memcmp(header->magic, magic, sizeof magic) != 0 || header->version != version) {
+            return false;
+        }
+        p += sizeof(Header);
+        auto section = [&p, end](auto*& records, size_t count) {
+            using T = std::remove_const_t<std::remove_reference_t<decltype(*records)>>;
+            if (size_t(end - p) < count * sizeof(T)) {
+                return false;
+            }
+            records = reinterpret_cast<const T*>(p);
+            p += count * sizeof(T);
+            return true;
+        };
+        return section(imports,    header->num_imports)
+            && section(typedefs,   header->num_typedefs)
+            && section(procedures, header->num_procedures)
+            && section(nodes,      header->num_nodes)
+            && section(children,   header->num_children)
+            && section(strings,    header->strings_size)
+            && valid();
+    }
+
+    bool valid_string(String s) const {
+        return s.offset <= header->strings_size && s.size <= header->strings_size - s.offset;
+    }
+
+    bool valid_children(uint32_t first, uint32_t count) const {
+        if (first > header->num_children || count > header->num_children - first) {
+            return false;
+        }
+        return std::all_of(children + first, children + first + count,
+                           [this](uint32_t c) { return c < header->num_nodes; });
+    }
+
+    // every reference is in bounds. children are written before their parents,
+    // so requiring smaller indices also rules out cycles
+    bool valid() const {
+        for (uint32_t i = 0; i < header->num_nodes; ++i) {
+            const TypeNode& n = nodes[i];
+            if (!valid_string(n.name) || !valid_children(n.first_child, n.num_children) ||
+                !std::all_of(children + n.first_child, children + n.first_child + n.num_children,
+                             [i](uint32_t c) { return c < i; }) ||
+                (n.kind == TypeNode::field && n.num_children != 1) || n.kind > TypeNode::field) {
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header->num_imports; ++i) {
+            if (!valid_string(imports[i])) {
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header->num_typedefs; ++i) {
+            if (!valid_string(typedefs[i].name) || typedefs[i].type >= header->num_nodes) {
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header->num_procedures; ++i) {
+            const ProcedureRecord& proc = procedures[i];
+            if (!valid_string(proc.name) || !valid_string(proc.symbol) ||
+                proc.return_type >= header->num_nodes || !valid_children(proc.first_param, proc.num_params)) {
+                return false;
+            }
+            // parameters are read as fields, which have exactly one child
+            if (!std::all_of(children + proc.first_param, children + proc.first_param + proc.num_params,
+                             [this](uint32_t c) { return nodes[c].kind == TypeNode::field; })) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string string(String s) const {
+        return std::string(strings + s.offset, s.size);
+    }
+
+    Declaration field(const TypeNode& n) const {
+        std::string name = string(n.name);
+        Identifier id = intern_identifier(name);
+        return Declaration{ Variable{ std::move(name), id }, type(children[n.first_child]), std::nullopt };
+    }
+
+    Type type(uint32_t index) const {
+        const TypeNode& n = nodes[index];
+        Type t{ string(n.name) };
+        for (uint32_t i = n.first_child; i < n.first_child + n.num_children; ++i) {
+            const TypeNode& child = nodes[children[i]];
+            switch (child.kind) {
+            case TypeNode::type:
+                t.parameters.push_back(type(children[i]));
+                break;
+            case TypeNode::size:
+                t.parameters.push_back(size_t(child.value));
+                break;
+            default:
+                t.parameters.push_back(field(child));
+                break;
+            }
+        }
+        return t;
+    }
+};
+
+}
+
+Block* read_interface(const std::string& path) {
+    // large files are mapped rather than read
+    auto buffer = llvm::MemoryBuffer::getFile(path, /* FileSize */ -1, /* RequiresNullTerminator */ false);
+    if (!buffer) {
+        std::cerr << "could not open " << path << ": " << buffer.getError().message() << std::endl;
+        return nullptr;
+    }
+    Reader r;
+    if (!r.map((*buffer)->getBuffer())) {
+        std::cerr << path << " is not a module interface of this version of rhythmc" << std::endl;
+        return nullptr;
+    }
+
+    Block* module = parse_arena.make<Block>();
+    for (uint32_t i = 0; i < r.header->num_imports; ++i) {
+        module->statements.push_back(Statement{ Import{ r.string(r.imports[i]) } });
+    }
+    for (uint32_t i = 0; i < r.header->num_typedefs; ++i) {
+        const TypedefRecord& def = r.typedefs[i];
+        module->statements.push_back(Statement{ Typedef{ r.string(def.name), r.type(def.type) } });
+    }
+    for (uint32_t i = 0; i < r.header->num_procedures; ++i) {
+        const ProcedureRecord& rec = r.procedures[i];
+        Procedure proc{ r.string(rec.name), {}, r.type(rec.return_type), Block{} };
+        for (uint32_t p = rec.first_param; p < rec.first_param + rec.num_params; ++p) {
+            proc.parameters.push_back(r.field(r.nodes[r.children[p]]));
+        }
+        proc.symbol = r.string(rec.symbol);
+        proc.attributes = Procedure::exported;
+        module->statements.push_back(Statement{ std::move(proc) });
+    }
+    return module;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef INTERFACE_HPP
+#define INTERFACE_HPP
+
+#include <string>
+#include "parse_tree.hpp"
+
+// module interfaces (.rhi): what other modules need to import a compiled
+// module, without its procedure bodies. a flat binary file of fixed size
+// records, read in place from a memory mapping
+
+// writes the imports, typedefs (with field indices) and exported procedure
+// signatures (with linkage names) of `program`. the file is left untouched if it would
+// not change, so its modification time tells when the interface last changed.
+// precondition: the program was type checked
+bool write_interface(const Block& program, const std::string& path);
+
+// the interface as a parse tree of imports, typedefs and procedures without
+// bodies (see Procedure::symbol). nullptr, and says why, if it can't be read
+Block* read_interface(const std::string& path);
+
+#endif
\ No newline at end of file
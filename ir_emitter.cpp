@@ -4,7 +4,10 @@
 #include <string_view>
 #include <string>
 #include <map>
+#include <set>
+#include <unordered_map>
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/Analysis/VectorUtils.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -12,24 +15,33 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Verifier.h"
+#include "constant_eval.hpp"
+#include "generics.hpp"
+#include "overloads.hpp"
 #include "parse_tree.hpp"
 #include "type_system.hpp"
 #include "llvm_intrinsics.hpp"
 #include "symbol_table.hpp"
 
-llvm::LLVMContext context;
-llvm::IRBuilder<> builder(context);
-std::unique_ptr<llvm::Module> module = std::make_unique<llvm::Module>("rhythm", context);
-// TODO: add stack frames
-SymbolTable<Variable, llvm::AllocaInst> variable_table;
-SymbolTable<Type, llvm::Type> type_table;
-std::map<std::string, std::map<std::string, llvm::ConstantInt*>> struct_field_indices;
-
-std::map<Type, llvm::Type*> llvm_types = {
-    { TypeSystem::Intrinsics::boolean, llvm::Type::getInt8Ty   (context) },
+// the context is owned through a pointer so it can be handed off together with
+// the module (e.g. to the JIT).
+// all emitter state is per thread, so every thread emits into a context and
+// module of its own (see emit_parallel)
+thread_local std::unique_ptr<llvm::LLVMContext> owned_context = std::make_unique<llvm::LLVMContext>();
+thread_local llvm::LLVMContext& context = *owned_context;
+thread_local llvm::IRBuilder<> builder(context);
+thread_local std::unique_ptr<llvm::Module> module = std::make_unique<llvm::Module>("rhythm", context);
+// stack slots of locals and parameters, or global variables
+thread_local SymbolTable<Variable, llvm::Value> variable_table;
+
+// lowered types, filled in lazily by llvm_type for constructed types
+thread_local std::unordered_map<TypeSystem::TypeRef, llvm::Type*> llvm_types = {
+    { TypeSystem::Intrinsics::boolean, llvm::Type::getInt1Ty   (context) },
     { TypeSystem::Intrinsics::integer, llvm::Type::getInt32Ty  (context) },
     { TypeSystem::Intrinsics::int8,    llvm::Type::getInt8Ty   (context) },
     { TypeSystem::Intrinsics::int16,   llvm::Type::getInt16Ty  (context) },
@@ -46,12 +58,58 @@ std::map<Type, llvm::Type*> llvm_types = {
 };
 
 
+// type based alias analysis
+// -------------------------
+// as in C, an access of one type can't modify memory read as another type.
+// integers of the same width share a type (Int, Int32 and Nat32 may alias),
+// all pointers share one, and bytes, Bools and aggregates may alias anything.
+// vector lanes are accessed as their lane type
+thread_local std::unordered_map<std::string, llvm::MDNode*> tbaa_nodes;
+
+static llvm::MDNode* tbaa_node(const std::string& name) {
+    if (auto it = tbaa_nodes.find(name); it != tbaa_nodes.end()) {
+        return it->second;
+    }
+    llvm::MDBuilder md(context);
+    llvm::MDNode*& node = tbaa_nodes[name];
+    if (name == "omnipotent char") {
+        node = md.createTBAAScalarTypeNode(name, md.createTBAARoot("Rhythm TBAA"));
+    }
+    else {
+        node = md.createTBAAScalarTypeNode(name, tbaa_node("omnipotent char"));
+    }
+    return node;
+}
+
+static llvm::MDNode* tbaa_tag(TypeSystem::TypeRef type) {
+    TypeSystem::TypeRef t = TypeSystem::element_type(type);
+    std::string name = "omnipotent char";
+    if (TypeSystem::is_pointer(t)) {
+        name = "any pointer";
+    }
+    else if (TypeSystem::is_integral(t) && TypeSystem::size_of(t) > 1) {
+        name = "int" + std::to_string(8 * TypeSystem::size_of(t));
+    }
+    else if (TypeSystem::is_floating_point(t)) {
+        name = t->mangled;
+    }
+    llvm::MDNode* node = tbaa_node(name);
+    return llvm::MDBuilder(context).createTBAAStructTagNode(node, node, 0);
+}
+
+// tag a load or store of a value of the given type
+template<typename Inst>
+static Inst* tbaa(Inst* inst, TypeSystem::TypeRef type) {
+    inst->setMetadata(llvm::LLVMContext::MD_tbaa, tbaa_tag(type));
+    return inst;
+}
+
 // create_entry_alloca - Create an alloca instruction in the entry block of
 // the function.  This is used for mutable variables etc.
 // TODO: type of var
 llvm::AllocaInst *create_entry_block_alloca(llvm::Function* f, const Declaration& decl) {
     llvm::IRBuilder<> tmp_b(&f->getEntryBlock(), f->getEntryBlock().begin());
-    return tmp_b.CreateAlloca(llvm_type(decl.type), 0, decl.variable.name.c_str());
+    return tmp_b.CreateAlloca(llvm_type(TypeSystem::intern(decl.type)), 0, decl.variable.name.c_str());
 }
 
 void cstdlib() {
@@ -77,87 +135,68 @@ llvm::Value *error(std::string_view str) {
     return nullptr;
 }
 
-std::string decorate_name(const Invocation& invoc) {
-    std::string name = invoc.name;
-    for (const auto& expr : invoc.args) {
-        name += "_" + to_string(TypeSystem::type_of(expr));
-    }
-    return name;
-}
-
 std::string decorate_name(const Procedure& proc) {
     std::string name = proc.name;
     for (const auto& decl : proc.parameters) {
-        name += "_" + to_string(decl.type);
+        name += "_" + TypeSystem::intern(decl.type)->mangled;
     }
     return name;
 }
 
-llvm::Type* llvm_type(const Type& type) {
-    if (type.parameters.empty()) {
-        llvm::Type* t = type_table.find(type);
-        if (t) {
-            return t;
-        }
-        if (auto it = llvm_types.find(type); it != llvm_types.end()) {
-            return it->second;
-        }
-        
-        return (llvm::Type*) error("unknown type " + type.name);
+llvm::Type* llvm_type(TypeSystem::TypeRef type) {
+    if (auto it = llvm_types.find(type); it != llvm_types.end()) {
+        return it->second;
     }
 
-    if (type.name == "Struct") {
-        std::vector<llvm::Type*> types(type.parameters.size());
-
-        std::transform(type.parameters.begin(), type.parameters.end(),
-                       types.begin(),
-                       [] (const auto& variant) -> llvm::Type* {
-                           if (std::holds_alternative<Declaration>(variant)) {
-                                return llvm_type(std::get<Declaration>(variant).type);
-                           }
-                           if (std::holds_alternative<Type>(variant)) {
-                                return llvm_type(std::get<Type>(variant));
-                           }
-
-                           return nullptr;
-                       });
-
-        llvm::StructType* st = llvm::StructType::create(context, types);
-
-        // TODO: default name for anonymous struct
-        for (size_t i = 0; i < type.parameters.size(); ++i) {
-            if (!std::holds_alternative<Declaration>(type.parameters[i])) {
-                return nullptr;
-            }
-            const std::string& name = std::get<Declaration>(type.parameters[i]).variable.name;
-            struct_field_indices[st->getName().str()][name] = builder.getInt32(i);
+    llvm::Type* t = nullptr;
+    if (TypeSystem::is_structure(type)) {
+        // typedef'd structs are named. the struct is cached before its body is
+        // lowered so that fields may point back to it
+        llvm::StructType* st = type->name == TypeSystem::Intrinsics::structure
+                             ? llvm::StructType::create(context)
+                             : llvm::StructType::create(context, type->name);
+        llvm_types[type] = st;
+
+        std::vector<llvm::Type*> types;
+        for (TypeSystem::TypeRef field : TypeSystem::field_types(type)) {
+            types.push_back(llvm_type(field));
         }
-
+        if (std::find(types.begin(), types.end(), nullptr) != types.end()) {
+            return (llvm::Type*) error("bad field type in " + type->name);
+        }
+        st->setBody(types);
         return st;
     }
-    else if (type.name == "Pointer") {
-        // TODO: segfaulting when params is empty
-        if (type.parameters.size() != 1 || !std::holds_alternative<Type>(type.parameters[0])) {
-            return (llvm::Type*) error("`Pointer` expects 1 parameter: (value type)");
-        }
+    else if (TypeSystem::is_pointer(type)) {
         // TODO: address space?
-        return llvm::PointerType::getUnqual(llvm_type(std::get<Type>(type.parameters[0])));
+        llvm::Type* value_type = llvm_type(type->value_type);
+        if (!value_type) {
+            return nullptr;
+        }
+        // pointers to void are represented as i8*
+        t = value_type->isVoidTy() ? llvm::Type::getInt8PtrTy(context)
+                                   : llvm::PointerType::getUnqual(value_type);
     }
-    else if (type.name == "Array") {
-        if (type.parameters.size() != 2 
-            || !std::holds_alternative<Type>(type.parameters[0])
-            || !std::holds_alternative<size_t>(type.parameters[1]))
-        {
-            return (llvm::Type*) error("`Array` expects 2 parameters: (value type, size)");
+    else if (TypeSystem::is_array(type)) {
+        llvm::Type* value_type = llvm_type(type->value_type);
+        if (!value_type) {
+            return nullptr;
         }
-        // TODO: address space?
-        const Type& t = std::get<Type>(type.parameters[0]);
-        size_t sz = std::get<size_t>(type.parameters[1]);
-        return llvm::ArrayType::get(llvm_type(t), sz);
+        t = llvm::ArrayType::get(value_type, TypeSystem::num_elements(type));
+    }
+    else if (TypeSystem::is_vector(type)) {
+        llvm::Type* value_type = llvm_type(type->value_type);
+        if (!value_type) {
+            return nullptr;
+        }
+        t = llvm::FixedVectorType::get(value_type, TypeSystem::num_elements(type));
+    }
+    else {
+        return (llvm::Type*) error("bad type " + type->mangled);
     }
-    
 
-    return (llvm::Type*) error("bad type");
+    llvm_types[type] = t;
+    return t;
 }
 
 llvm::Value* emit_expr(const Literal& lit, bool addr) {
@@ -181,7 +220,7 @@ llvm::Value* emit_expr(const Literal& lit, bool addr) {
 
 llvm::Value* emit_expr(const Variable& variable, bool addr) {
     // Look this variable up in the function.
-    llvm::AllocaInst *v = variable_table.find(variable);
+    llvm::Value* v = variable_table.find(variable);
     if (!v) {
         return error("unknown variable `" + variable.name + "`");
     }
@@ -190,7 +229,143 @@ llvm::Value* emit_expr(const Variable& variable, bool addr) {
     }
 
     // Load the value.
-    return builder.CreateLoad(v, variable.name.c_str());
+    return tbaa(builder.CreateLoad(v, variable.name.c_str()), TypeSystem::type_of(variable));
+}
+
+// lhs && rhs, lhs || rhs. rhs is only evaluated if lhs does not decide the result
+static llvm::Value* emit_short_circuit(const Invocation& invoc) {
+    if (invoc.args.size() != 2) {
+        return error("`" + invoc.name + "` expects 2 parameters");
+    }
+    bool is_and = invoc.name == "&&";
+
+    llvm::Value* lhs = emit_expr(invoc.args[0]);
+    if (!lhs) {
+        return error("bad input");
+    }
+
+    llvm::Function* f = builder.GetInsertBlock()->getParent();
+    llvm::BasicBlock* lhs_block = builder.GetInsertBlock();
+    llvm::BasicBlock* rhs_block = llvm::BasicBlock::Create(context, is_and ? "and.rhs" : "or.rhs", f);
+    llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(context, is_and ? "and.cont" : "or.cont");
+
+    if (is_and) {
+        builder.CreateCondBr(lhs, rhs_block, merge_block);
+    }
+    else {
+        builder.CreateCondBr(lhs, merge_block, rhs_block);
+    }
+
+    builder.SetInsertPoint(rhs_block);
+    llvm::Value* rhs = emit_expr(invoc.args[1]);
+    if (!rhs) {
+        return error("bad input");
+    }
+    builder.CreateBr(merge_block);
+    // rhs may have changed insertion block (e.g. nested && or ||)
+    rhs_block = builder.GetInsertBlock();
+
+    f->getBasicBlockList().push_back(merge_block);
+    builder.SetInsertPoint(merge_block);
+    llvm::PHINode* phi = builder.CreatePHI(builder.getInt1Ty(), 2);
+    phi->addIncoming(builder.getInt1(!is_and), lhs_block);
+    phi->addIncoming(rhs, rhs_block);
+    return phi;
+}
+
+// the value of an integer literal argument, checked by the type checker
+static unsigned literal_value(const Expression& expr) {
+    return std::stoul(std::get<Literal>(expr.value).value);
+}
+
+// see TypeSystem::is_vector_builtin. vectors are loaded from and stored to
+// element pointers, so only the alignment of an element is assumed
+static llvm::Value* emit_vector_builtin(const Invocation& invoc) {
+    // lane counts and shuffle indices are literals, read by literal_value
+    size_t values = invoc.name == "load" || invoc.name == "splat" ? 1
+                  : invoc.name == "shuffle"                       ? 2
+                                                                  : invoc.args.size();
+    std::vector<llvm::Value*> args;
+    for (size_t i = 0; i < values; ++i) {
+        llvm::Value* v = emit_expr(invoc.args[i]);
+        if (!v) {
+            return error("bad arguments to `" + invoc.name + "`");
+        }
+        args.push_back(v);
+    }
+
+    // the pointer, vector or (for splat) lane type of the first argument
+    TypeSystem::TypeRef first = TypeSystem::type_of(invoc.args.front());
+    if (invoc.name == "load") {
+        llvm::Type* t = llvm_type(TypeSystem::Intrinsics::make_vector(first->value_type, literal_value(invoc.args[1])));
+        llvm::Value* ptr = builder.CreateBitCast(args[0], llvm::PointerType::getUnqual(t));
+        return tbaa(builder.CreateAlignedLoad(t, ptr, llvm::MaybeAlign(TypeSystem::size_of(first->value_type))),
+                    first->value_type);
+    }
+    if (invoc.name == "store") {
+        llvm::Value* ptr = builder.CreateBitCast(args[0], llvm::PointerType::getUnqual(args[1]->getType()));
+        return tbaa(builder.CreateAlignedStore(args[1], ptr, llvm::MaybeAlign(TypeSystem::size_of(first->value_type))),
+                    first->value_type);
+    }
+    if (invoc.name == "splat") {
+        return builder.CreateVectorSplat(literal_value(invoc.args[1]), args[0]);
+    }
+    if (invoc.name == "extract") {
+        return builder.CreateExtractElement(args[0], args[1]);
+    }
+    if (invoc.name == "insert") {
+        return builder.CreateInsertElement(args[0], args[2], args[1]);
+    }
+    if (invoc.name == "shuffle") {
+        std::vector<int> mask;
+        for (size_t i = 2; i < invoc.args.size(); ++i) {
+            mask.push_back(literal_value(invoc.args[i]));
+        }
+        return builder.CreateShuffleVector(args[0], args[1], mask);
+    }
+
+    // reductions. floating point sums and products may be reassociated into a tree
+    TypeSystem::TypeRef lane = first->value_type;
+    bool is_signed = TypeSystem::is_signed_integral(lane);
+    if (TypeSystem::is_floating_point(lane)) {
+        llvm::Instruction* r = nullptr;
+        if (invoc.name == "reduce_add") {
+            r = llvm::cast<llvm::Instruction>(builder.CreateFAddReduce(llvm::ConstantFP::get(llvm_type(lane), -0.0), args[0]));
+        }
+        else if (invoc.name == "reduce_mul") {
+            r = llvm::cast<llvm::Instruction>(builder.CreateFMulReduce(llvm::ConstantFP::get(llvm_type(lane), 1.0), args[0]));
+        }
+        else if (invoc.name == "reduce_min") {
+            return builder.CreateFPMinReduce(args[0]);
+        }
+        else if (invoc.name == "reduce_max") {
+            return builder.CreateFPMaxReduce(args[0]);
+        }
+        if (r) {
+            r->setHasAllowReassoc(true);
+            return r;
+        }
+    }
+    else if (invoc.name == "reduce_add") {
+        return builder.CreateAddReduce(args[0]);
+    }
+    else if (invoc.name == "reduce_mul") {
+        return builder.CreateMulReduce(args[0]);
+    }
+    else if (invoc.name == "reduce_min") {
+        return builder.CreateIntMinReduce(args[0], is_signed);
+    }
+    else if (invoc.name == "reduce_max") {
+        return builder.CreateIntMaxReduce(args[0], is_signed);
+    }
+    else if (invoc.name == "reduce_and") {
+        return builder.CreateAndReduce(args[0]);
+    }
+    else if (invoc.name == "reduce_or") {
+        return builder.CreateOrReduce(args[0]);
+    }
+
+    return error("bad arguments to `" + invoc.name + "`");
 }
 
 llvm::Value* emit_expr(const Invocation& invoc, bool addr) {	
@@ -208,10 +383,13 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
         if (!r) {
             return error("bad rvalue in assignment");
         }
-        builder.CreateStore(r, ptr);
+        tbaa(builder.CreateStore(r, ptr), TypeSystem::type_of(invoc.args[0]));
         // TODO (?): forbid assignment as expression
         return ptr;
     }
+    else if (invoc.name == "[]") {
+        return error("array literals only initialize globals and let variables");
+    }
     else if (invoc.name == ".") {
         if (invoc.args.size() != 2) {
             return error("too many arguments to field access");
@@ -224,30 +402,24 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
         if (!struct_ptr) {
             return error("bad struct");
         }
-        //return error("field access not supported");
-        // TODO access other fields besides first
-        auto at = llvm::cast<llvm::ArrayType>(struct_ptr->getType());
-        auto st = llvm::cast<llvm::StructType>(at->getElementType());
 
-        auto it1 = struct_field_indices.find(st->getName().str());
-        if (it1 == struct_field_indices.end()) {
+        TypeSystem::TypeRef struct_type = TypeSystem::type_of(invoc.args[0]);
+        if (!TypeSystem::is_structure(struct_type)) {
             return error("no such struct type");
         }
-        const auto& field_indices = it1->second;
-        auto it2 = field_indices.find(field_name);
-        if (it2 == field_indices.end()) {
+        int field_index = TypeSystem::field_index(struct_type, field_name);
+        if (field_index < 0) {
             return error("no such field");
         }
-        llvm::ConstantInt* field_index = it2->second;
         std::vector<llvm::Value*> indices = {
-            builder.getInt64(0), field_index
+            builder.getInt64(0), builder.getInt32(field_index)
         };
         llvm::Value* field_ptr = builder.CreateGEP(struct_ptr, llvm::ArrayRef(indices));
         if (addr) {
             return field_ptr;
         }
 
-        return builder.CreateLoad(field_ptr);
+        return tbaa(builder.CreateLoad(field_ptr), struct_type->fields[field_index].second);
     }
     else if (invoc.name == "address") {
         if (invoc.args.size() != 1) {
@@ -268,14 +440,14 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
             return v;
         }
 
-        return builder.CreateLoad(v);
+        return tbaa(builder.CreateLoad(v), TypeSystem::value_type(TypeSystem::type_of(invoc.args[0])));
     }
     else if (invoc.name == "begin") {
         if (invoc.args.size() != 1) {
             return error("`begin` expects 1 parameter: (range)");
         }
         llvm::Value* arr = emit_expr(invoc.args[0], true);
-        llvm::Type* value_type = llvm::cast<llvm::ArrayType>(arr->getType())->getElementType()->getArrayElementType();
+        llvm::Type* value_type = llvm_type(TypeSystem::value_type(TypeSystem::type_of(invoc.args[0])));
         // TODO: generalize for arrays of any type
         return builder.CreateBitCast(arr, llvm::PointerType::getUnqual(value_type));
     }
@@ -284,7 +456,7 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
             return error("`limit` expects 1 parameter: (range)");
         }
         llvm::Value* arr = emit_expr(invoc.args[0], true);
-        llvm::Type* value_type = llvm::cast<llvm::ArrayType>(arr->getType())->getElementType()->getArrayElementType();
+        llvm::Type* value_type = llvm_type(TypeSystem::value_type(TypeSystem::type_of(invoc.args[0])));
 
         return builder.CreateBitCast(builder.CreateGEP(arr, builder.getInt64(1)), llvm::PointerType::getUnqual(value_type));
     }
@@ -304,7 +476,14 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
         return error("bad type to `successor`");
     }
 
+    else if (TypeSystem::is_vector_builtin(invoc)) {
+        return emit_vector_builtin(invoc);
+    }
+
     // built-in op
+    if (invoc.name == "&&" || invoc.name == "||") {
+        return emit_short_circuit(invoc);
+    }
     if (TypeSystem::is_intrinsic_op(invoc)) {
         if (invoc.args.size() == 1) {
             llvm::Value* v = emit_expr(invoc.args[0]);
@@ -326,11 +505,21 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
     // other defined function
 
     // TODO: extern c
-    std::string name = decorate_name(invoc);
-    if (TypeSystem::is_intrinsic_op(invoc) || invoc.name == "printf" || invoc.name == "scanf") {
-        name = invoc.name;
+    llvm::Function *callee = nullptr;
+    if (invoc.name == "printf" || invoc.name == "scanf") {
+        callee = module->getFunction(invoc.name);
+    }
+    else {
+        // the overload the type checker resolved the call to. it is declared
+        // here if it is defined later (e.g. an instance of a generic procedure)
+        std::vector<TypeSystem::TypeRef> arg_types;
+        for (const Expression& arg : invoc.args) {
+            arg_types.push_back(TypeSystem::type_of(arg));
+        }
+        if (const Procedure* proc = resolve_overload(invoc.name, arg_types)) {
+            callee = declare_procedure(*proc);
+        }
     }
-    llvm::Function *callee = module->getFunction(name);
     if (!callee) {	
         return error("call to unknown procedure " + invoc.name);	
     }	
@@ -359,10 +548,8 @@ llvm::Value* emit_expr(const Invocation& invoc, bool addr) {
     return builder.CreateCall(callee, llvm_args);	
 }
 
-llvm::Value* emit_expr(const TypeCast& cast, bool addr) {
-    Type from = TypeSystem::type_of(*cast.expr);
-    const Type& to = cast.type;
-    llvm::Value* v = emit_expr(*cast.expr, addr);
+// v, of type `from`, as a value of type `to`: a cast, or the conversion of an initializer
+static llvm::Value* emit_conversion(llvm::Value* v, TypeSystem::TypeRef from, TypeSystem::TypeRef to) {
     llvm::Type* t = llvm_type(to);
 
     if (TypeSystem::is_unsigned_integral(from)) {
@@ -395,7 +582,7 @@ llvm::Value* emit_expr(const TypeCast& cast, bool addr) {
             return builder.CreateFPToSI(v, t);
         }
         else if (TypeSystem::is_floating_point(to)) {
-            if (TypeSystem::size_of(from) < TypeSystem::size_of(to)) {
+            if (TypeSystem::size_of(from) > TypeSystem::size_of(to)) {
                 return builder.CreateFPTrunc(v, t);
             }
             else {
@@ -422,7 +609,35 @@ llvm::Value* emit_expr(const TypeCast& cast, bool addr) {
     return error("unknown conversion");
 }
 
+llvm::Value* emit_expr(const TypeCast& cast, bool addr) {
+    llvm::Value* v = emit_expr(*cast.expr, addr);
+    if (!v) {
+        return nullptr;
+    }
+    return emit_conversion(v, TypeSystem::type_of(*cast.expr), TypeSystem::type_of(cast));
+}
+
+// a number of the type the type checker annotated, rather than Int or Flt64.
+// constants folded by the type checker keep the type of the call they replace
+static llvm::Value* emit_typed_literal(const Literal& lit, TypeSystem::TypeRef type) {
+    llvm::Type* t = llvm_type(type);
+    if (lit.type == Literal::Type::rational || TypeSystem::is_floating_point(type)) {
+        return llvm::ConstantFP::get(t, lit.value);
+    }
+    if (TypeSystem::is_signed_integral(type)) {
+        return llvm::ConstantInt::get(t, uint64_t(std::stoll(lit.value)), true);
+    }
+    return llvm::ConstantInt::get(t, std::stoull(lit.value));
+}
+
 llvm::Value* emit_expr(const Expression& expr, bool addr) {
+    auto lit = std::get_if<Literal>(&expr.value);
+    if (lit && lit->type != Literal::Type::string && expr.type && !addr
+        && (TypeSystem::is_integral(expr.type) || TypeSystem::is_floating_point(expr.type)
+            || expr.type == TypeSystem::Intrinsics::boolean))
+    {
+        return emit_typed_literal(*lit, expr.type);
+    }
     return std::visit([addr] (auto& x) { return emit_expr(x, addr); }, expr.value);
 }
 
@@ -434,19 +649,82 @@ bool emit_stmt(const Expression& expr) {
 }
 
 
+// the llvm constant for a value of `type` made of `elements` (see
+// evaluate_initializer), starting at `next`
+static llvm::Constant* constant_data(TypeSystem::TypeRef type, const std::vector<Constant>& elements, size_t& next) {
+    llvm::Type* t = llvm_type(type);
+    if (TypeSystem::is_array(type)) {
+        std::vector<llvm::Constant*> values;
+        for (size_t i = 0; i < type->num_elements; ++i) {
+            values.push_back(constant_data(type->value_type, elements, next));
+        }
+        return llvm::ConstantArray::get(llvm::cast<llvm::ArrayType>(t), values);
+    }
+    const Constant& c = elements[next++];
+    if (TypeSystem::is_floating_point(type)) {
+        return llvm::ConstantFP::get(t, c.real);
+    }
+    return llvm::ConstantInt::get(t, uint64_t(c.integer), TypeSystem::is_signed_integral(type));
+}
+
+// globals, and let variables wherever they are declared, live in global
+// variables initialized with their data instead of being stored on every
+// entry. let data is read-only and has no identity of its own, so it goes in
+// .rodata and the linker may merge equal tables. only this module sees them
+static bool emit_global(const Declaration& decl) {
+    TypeSystem::TypeRef type = TypeSystem::intern(decl.type);
+    llvm::Type* t = llvm_type(type);
+    if (!t) {
+        error("bad type of " + decl.variable.name);
+        return false;
+    }
+
+    // without an initializer, globals start out zeroed like in C
+    llvm::Constant* init = llvm::Constant::getNullValue(t);
+    if (decl.initializer) {
+        std::string why;
+        std::optional<std::vector<Constant>> elements = evaluate_initializer(*decl.initializer, type, &why);
+        if (!elements) {
+            error("initializer of " + decl.variable.name + " is not constant data: " + why);
+            return false;
+        }
+        size_t next = 0;
+        init = constant_data(type, *elements, next);
+    }
+
+    auto linkage = decl.constant ? llvm::GlobalValue::PrivateLinkage : llvm::GlobalValue::InternalLinkage;
+    auto global = new llvm::GlobalVariable(*module, t, decl.constant, linkage, init, decl.variable.name);
+    if (decl.constant) {
+        global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    }
+    variable_table.add(decl.variable, global);
+    return true;
+}
+
 bool emit_stmt(const Declaration& decl) {
     if (variable_table.find_current_frame(decl.variable)) {
         error("variable \"" + decl.variable.name + "\" is already declared in this scope");
         return false;
     }
+    if (decl.global || decl.constant) {
+        return emit_global(decl);
+    }
     llvm::Function* f = builder.GetInsertBlock()->getParent();
 
     llvm::AllocaInst* alloc = create_entry_block_alloca(f, decl);
 
     // store initializer, if applicable. otherwise, the value is undefined
     if (decl.initializer) {
+        TypeSystem::TypeRef type = TypeSystem::intern(decl.type);
         llvm::Value* init_val = emit_expr(*decl.initializer);
-        builder.CreateStore(init_val, alloc);
+        // converted like the data of globals, see initializes in the type checker
+        if (init_val && decl.initializer->type != type) {
+            init_val = emit_conversion(init_val, decl.initializer->type, type);
+        }
+        if (!init_val) {
+            return false;
+        }
+        tbaa(builder.CreateStore(init_val, alloc), type);
     }
 
     variable_table.add(decl.variable, alloc);
@@ -493,9 +771,7 @@ bool emit_stmt_current_frame(const Block& block) {
 
 bool emit_stmt(const Block& block) {
     variable_table.push_frame();
-    type_table.push_frame();
     bool success = emit_stmt_current_frame(block);
-    type_table.pop_frame();
     variable_table.pop_frame();
     return success;
 }
@@ -513,9 +789,6 @@ bool emit_stmt(const Conditional& cond) {
     llvm::BasicBlock* else_block = llvm::BasicBlock::Create(context, "else");
     llvm::BasicBlock* merge_block = llvm::BasicBlock::Create(context, "ifcont");
 
-    if (TypeSystem::type_of(cond.condition) == TypeSystem::Intrinsics::boolean) {
-        condition = builder.CreateICmpNE(condition, builder.getInt8(0)); // convert boolean i8 to i1
-    }
     builder.CreateCondBr(condition, then_block, else_block);
     builder.SetInsertPoint(then_block);
 
@@ -549,6 +822,58 @@ bool emit_stmt(const Conditional& cond) {
     return true;
 }
 
+// llvm.loop metadata for the hints (as clang emits for #pragma clang loop), or
+// null if there are none. with `independent`, the memory accesses of the loop's
+// blocks, from header to the end of the function, join an access group that the
+// metadata marks as parallel, so the vectorizer needs no runtime alias checks.
+// local variables (e.g. the loop counter) are left out, mem2reg promotes them
+static llvm::MDNode* loop_metadata(const LoopHints& hints, llvm::BasicBlock* header) {
+    auto hint = [](const char* name, llvm::Constant* value = nullptr) -> llvm::Metadata* {
+        std::vector<llvm::Metadata*> ops = { llvm::MDString::get(context, name) };
+        if (value) {
+            ops.push_back(llvm::ConstantAsMetadata::get(value));
+        }
+        return llvm::MDNode::get(context, ops);
+    };
+
+    // the first operand refers to the node itself
+    std::vector<llvm::Metadata*> ops = { nullptr };
+    if (hints.vectorize_width) {
+        ops.push_back(hint("llvm.loop.vectorize.width", builder.getInt32(hints.vectorize_width)));
+    }
+    if (hints.vectorize_width > 1 || (hints.independent && !hints.vectorize_width)) {
+        ops.push_back(hint("llvm.loop.vectorize.enable", builder.getTrue()));
+    }
+    if (hints.unroll_count == 1) {
+        ops.push_back(hint("llvm.loop.unroll.disable"));
+    }
+    else if (hints.unroll_count > 1) {
+        ops.push_back(hint("llvm.loop.unroll.count", builder.getInt32(hints.unroll_count)));
+    }
+    if (hints.independent) {
+        llvm::MDNode* group = llvm::MDNode::getDistinct(context, {});
+        llvm::Function* f = header->getParent();
+        for (auto bb = header->getIterator(); bb != f->end(); ++bb) {
+            for (llvm::Instruction& inst : *bb) {
+                llvm::Value* ptr = llvm::getLoadStorePointerOperand(&inst);
+                if (inst.mayReadOrWriteMemory() && !(ptr && llvm::isa<llvm::AllocaInst>(ptr))) {
+                    // accesses of an inner independent loop keep its group as well
+                    inst.setMetadata(llvm::LLVMContext::MD_access_group,
+                        llvm::uniteAccessGroups(inst.getMetadata(llvm::LLVMContext::MD_access_group), group));
+                }
+            }
+        }
+        ops.push_back(llvm::MDNode::get(context, { llvm::MDString::get(context, "llvm.loop.parallel_accesses"), group }));
+    }
+    if (ops.size() == 1) {
+        return nullptr;
+    }
+
+    llvm::MDNode* loop_id = llvm::MDNode::getDistinct(context, ops);
+    loop_id->replaceOperandWith(0, loop_id);
+    return loop_id;
+}
+
 bool emit_stmt(const WhileLoop& loop) {
     llvm::Function* f = builder.GetInsertBlock()->getParent();
 
@@ -577,8 +902,11 @@ bool emit_stmt(const WhileLoop& loop) {
         return false;
     }
 
-    // always branch back to check the condition
-    builder.CreateBr(cond_block);
+    // always branch back to check the condition. the back edge carries the hints
+    llvm::BranchInst* latch = builder.CreateBr(cond_block);
+    if (llvm::MDNode* md = loop_metadata(loop.hints, cond_block)) {
+        latch->setMetadata(llvm::LLVMContext::MD_loop, md);
+    }
 
     // continue code after while loop
     f->getBasicBlockList().push_back(cont_block);
@@ -587,32 +915,61 @@ bool emit_stmt(const WhileLoop& loop) {
     return true;
 }
 
-bool emit_stmt(const Procedure& proc) {
-    // check for function redefinition	
-    // TODO: function hoisting?
-    llvm::Function *redef_check = module->getFunction(decorate_name(proc));	
-    if(redef_check && !redef_check->empty()) {	
-        error("function " + proc.name + " redefined");	
-        return false;
-    }	
+llvm::Function* declare_procedure(const Procedure& proc) {
+    std::string name = proc.symbol.empty() ? decorate_name(proc) : proc.symbol;
+    if (llvm::Function* f = module->getFunction(name)) {
+        return f;
+    }
+
     // Make the function type:  int(int...) etc.
     std::vector<llvm::Type*> param_types(proc.parameters.size());
     std::transform(proc.parameters.begin(), proc.parameters.end(),
                    param_types.begin(),
                    [](const Declaration& t) {
-                       return llvm_type(t.type);
+                       return llvm_type(TypeSystem::intern(t.type));
                    });
     if (std::find(param_types.begin(), param_types.end(), nullptr) != param_types.end()) {
-        return error("bad parameter type");
+        error("bad parameter type");
+        return nullptr;
     }
     
-    llvm::Type* ret_type = llvm_type(proc.return_type);
+    llvm::Type* ret_type = llvm_type(TypeSystem::intern(proc.return_type));
     if (!ret_type) {
-        return error("bad return type");
+        error("bad return type");
+        return nullptr;
     }
     llvm::FunctionType* ft = llvm::FunctionType::get(ret_type, param_types, /*isVarArg=*/false);
 
-    llvm::Function* f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, decorate_name(proc), module.get());	
+    llvm::Function* f = llvm::Function::Create(ft, llvm::Function::ExternalLinkage, name, module.get());
+    for (size_t i = 0; i < proc.parameters.size(); ++i) {
+        if (proc.parameters[i].noalias) {
+            f->addParamAttr(i, llvm::Attribute::NoAlias);
+        }
+    }
+    return f;
+}
+
+bool emit_stmt(const Procedure& proc) {
+    // only its instances are emitted, see emit_program
+    if (!proc.type_parameters.empty()) {
+        return true;
+    }
+    llvm::Function* f = declare_procedure(proc);
+    if (!f) {
+        return false;
+    }
+    // check for function redefinition	
+    if (!f->empty()) {	
+        error("function " + proc.name + " redefined");	
+        return false;
+    }	
+    if (proc.attributes & Procedure::always_inline) {
+        f->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+    if (proc.attributes & Procedure::never_inline) {
+        f->addFnAttr(llvm::Attribute::NoInline);
+    }
+    TypeSystem::TypeRef return_type = TypeSystem::intern(proc.return_type);
 
     // Create a new basic block to start insertion into.	
     llvm::BasicBlock *bb = llvm::BasicBlock::Create(context, "entry", f);	
@@ -620,7 +977,6 @@ bool emit_stmt(const Procedure& proc) {
 
     // include parameters in stack frame
     variable_table.push_frame();
-    type_table.push_frame();
     // Set names for all arguments
     
     for_each_together(
@@ -629,26 +985,27 @@ bool emit_stmt(const Procedure& proc) {
         [f](auto& llvm_arg, const Declaration& formal_param) { 	
             llvm_arg.setName(formal_param.variable.name);	
             llvm::AllocaInst* alloc = create_entry_block_alloca(f, formal_param);
-            builder.CreateStore(&llvm_arg, alloc);
+            tbaa(builder.CreateStore(&llvm_arg, alloc), TypeSystem::intern(formal_param.type));
             if (variable_table.find_current_frame(formal_param.variable)) {
                 // TODO
                 // return error("variable " + formal_param.variable.name + " already defined in this scope");
             }
-            variable_table.add(formal_param.variable.name, alloc);
+            variable_table.add(formal_param.variable, alloc);
         }
     );
 
     if (!emit_stmt_current_frame(proc.block)) {
-        // Error reading body, remove function.	
-        f->eraseFromParent();	
+        // Error reading body, remove it. callers already emitted may refer to
+        // the function, so the declaration stays
+        variable_table.pop_frame();
+        f->deleteBody();
         error("could not generate procedure " + proc.name);	
         return false;
     }
-    type_table.pop_frame();
     variable_table.pop_frame();
 
     // add implicit return at the end of void function
-    if (proc.return_type == TypeSystem::Intrinsics::void0) {
+    if (return_type == TypeSystem::Intrinsics::void0) {
         builder.CreateRetVoid();
     }
 
@@ -658,41 +1015,83 @@ bool emit_stmt(const Procedure& proc) {
     return true;	
 }
 
+// lower the module's typedefs and declare its exported procedures, which are defined
+// in the module's own object. imports are transitive
+static bool declare_module(const Block& module, std::set<const Block*>& declared) {
+    if (!declared.insert(&module).second) {
+        return true;
+    }
+    for (const Statement& stmt : module.statements) {
+        if (auto def = std::get_if<Typedef>(&stmt.value); def && !emit_stmt(*def)) {
+            return false;
+        }
+        if (auto proc = std::get_if<Procedure>(&stmt.value); proc && proc->type_parameters.empty()
+            && (proc->attributes & Procedure::exported) && !declare_procedure(*proc)) {
+            return false;
+        }
+        if (auto import = std::get_if<Import>(&stmt.value); import && import->module
+            && !declare_module(*import->module, declared)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool emit_stmt(const Import& import) {
-    error("import not yet supported");
-    return false;
+    if (!import.module) {
+        error("unresolved import " + import.identifier);
+        return false;
+    }
+    thread_local std::set<const Block*> declared;
+    return declare_module(*import.module, declared);
 }
 
 bool emit_stmt(const Typedef& def) {
-    if (def.type.name != "Struct") {
+    TypeSystem::TypeRef type = TypeSystem::intern(Type{def.name});
+    if (!TypeSystem::is_structure(type)) {
         error("only Structs can be typedefed currently");
         return false;
     }
 
-    llvm::Type* t = llvm_type(def.type);
-    if (!t) {
-        error("could not emit type");
-        return false;
-    }
-    llvm::StructType* st = llvm::cast<llvm::StructType>(t);
-    if (!st) {
+    // lowering the named type creates (and names) the llvm struct
+    if (!llvm_type(type)) {
         error("could not emit type");
         return false;
     }
-    st->setName(def.name);
-    for (size_t i = 0; i < def.type.parameters.size(); ++i) {
-            if (!std::holds_alternative<Declaration>(def.type.parameters[i])) {
-                error("non-declaration in struct parameters");
-                return false;
-            }
-            const std::string& name = std::get<Declaration>(def.type.parameters[i]).variable.name;
-            struct_field_indices[st->getName().str()][name] = builder.getInt32(i);
-        }
-    type_table.add(Type{def.name}, t);
     return true;
 }
 
 
+bool emit_program(const Block& program) {
+    // instances may use the program's globals
+    variable_table.push_frame();
+    bool success = emit_stmt_current_frame(program);
+    for (size_t i = 0; success && i < procedure_instances.size(); ++i) {
+        success = emit_stmt(*procedure_instances[i]);
+    }
+    variable_table.pop_frame();
+    return success;
+}
+
+void internalize(const Block& program) {
+    auto internalize_procedure = [](const Procedure& proc) {
+        if (llvm::Function* f = module->getFunction(decorate_name(proc)); f && !f->isDeclaration()) {
+            f->setLinkage(llvm::GlobalValue::InternalLinkage);
+        }
+    };
+    for (const Statement& stmt : program.statements) {
+        auto proc = std::get_if<Procedure>(&stmt.value);
+        if (!proc || external_linkage(*proc) || !proc->type_parameters.empty()) {
+            continue;
+        }
+        internalize_procedure(*proc);
+    }
+    // every module has its own copies of the instances it calls
+    for (const Procedure* instance : procedure_instances) {
+        internalize_procedure(*instance);
+    }
+}
+
 bool emit_stmt(const Statement& stmt) {
     return std::visit([] (auto& x) { return emit_stmt(x); }, stmt.value);
 }
\ No newline at end of file
@@ -2,20 +2,29 @@
 #define CODE_GEN_HPP
 
 #include <memory>
+#include <unordered_map>
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/raw_ostream.h"
 #include "parse_tree.hpp"
+#include "type_system.hpp"
 
-extern std::unique_ptr<llvm::Module> module;
-extern llvm::LLVMContext context;
-extern std::map<Type, llvm::Type*> llvm_types;
+// per thread: each thread emits into its own context and module
+extern thread_local std::unique_ptr<llvm::Module> module;
+extern thread_local std::unique_ptr<llvm::LLVMContext> owned_context;
+extern thread_local llvm::LLVMContext& context;
+extern thread_local std::unordered_map<TypeSystem::TypeRef, llvm::Type*> llvm_types;
 
 
 void cstdlib();
-llvm::Type*  llvm_type(const Type& type);
+// linkage name of a procedure: its name decorated with its parameter types.
+// precondition: the procedure was type checked
+std::string decorate_name(const Procedure& proc);
+llvm::Type*  llvm_type(TypeSystem::TypeRef type);
+// the procedure's function in the current module, declared if it is not yet
+llvm::Function* declare_procedure(const Procedure& proc);
 
 llvm::Value* emit_expr(const Literal    & lit,   bool addr = false);
 llvm::Value* emit_expr(const Variable   & var,   bool addr = false);
@@ -26,10 +35,22 @@ llvm::Value* emit_expr(const Expression & expr,  bool addr = false);
 bool emit_stmt(const Expression  & expr );
 bool emit_stmt(const Block       & stmts);
 bool emit_stmt(const Declaration & decl );
+bool emit_stmt(const Import      & import);
 bool emit_stmt(const Return      & ret  );
 bool emit_stmt(const Conditional & cond );
 bool emit_stmt(const Procedure   & proc );
 bool emit_stmt(const Typedef     & def  );
 bool emit_stmt(const Statement   & stmt );
 
+// the program's top level statements, then the instances of generic
+// procedures made by the type checker (see generics.hpp). top level
+// declarations become global variables
+bool emit_program(const Block& program);
+
+// give the program's top level procedures internal linkage, unless they are
+// exported or main (see external_linkage), so the optimizer may inline them
+// into every caller and drop them. instances of generic procedures always get
+// it. run once the whole program is in `module`
+void internalize(const Block& program);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "jit.hpp"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+static int jit_error(llvm::Error err) {
+    llvm::logAllUnhandledErrors(std::move(err), llvm::errs(), "jit error: ");
+    return 1;
+}
+
+int run_jit(std::unique_ptr<llvm::Module> m, std::unique_ptr<llvm::LLVMContext> ctx) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    auto jit = llvm::orc::LLJITBuilder().create();
+    if (!jit) {
+        return jit_error(jit.takeError());
+    }
+
+    // resolve the c functions declared by cstdlib() in this process
+    auto host_symbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+        (*jit)->getDataLayout().getGlobalPrefix());
+    if (!host_symbols) {
+        return jit_error(host_symbols.takeError());
+    }
+    (*jit)->getMainJITDylib().addGenerator(std::move(*host_symbols));
+
+    if (auto err = (*jit)->addIRModule(llvm::orc::ThreadSafeModule(std::move(m), std::move(ctx)))) {
+        return jit_error(std::move(err));
+    }
+
+    auto main_symbol = (*jit)->lookup("main");
+    if (!main_symbol) {
+        return jit_error(main_symbol.takeError());
+    }
+
+    auto main_proc = reinterpret_cast<int (*)()>(main_symbol->getAddress());
+    return main_proc();
+}
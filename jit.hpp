@@ -0,0 +1,13 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include <memory>
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+// compile the module in-process with an ORC LLJIT and call its `main`.
+// external symbols (e.g. printf, scanf) are resolved against the host process.
+// returns the exit code of `main`, or 1 if the module could not be run
+int run_jit(std::unique_ptr<llvm::Module> m, std::unique_ptr<llvm::LLVMContext> ctx);
+
+#endif
@@ -20,11 +20,13 @@ static llvm::Value *error(std::string_view str) {
 llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, llvm::Value* v) {
     assert(invoc.args.size() == 1);
     using namespace TypeSystem;
+    // operand type, annotated by the type checker. vectors dispatch on their lane type
+    const TypeRef t = element_type(type_of(invoc.args.front()));
     if (invoc.name == "-") {
-        if (is_integral(type_of(invoc))) {
+        if (is_integral(t)) {
             return builder.CreateNeg(v);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFNeg(v);
         }
         else {
@@ -38,14 +40,18 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
 llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, llvm::Value* lhs, llvm::Value* rhs) {
     assert(invoc.args.size() == 2);
     using namespace TypeSystem;
+    // operand types, annotated by the type checker. intrinsic ops take the type of their lhs.
+    // vector ops are element-wise, and dispatch on the lane type
+    const TypeRef t = element_type(type_of(invoc.args.front()));
+    const TypeRef rhs_t = element_type(type_of(invoc.args.back()));
     if (invoc.name == "+") {
-        if (is_pointer(type_of(invoc.args.front())) && is_integral(type_of(invoc.args.back()))) {
+        if (is_pointer(t) && is_integral(rhs_t)) {
             return builder.CreateGEP(lhs, rhs);
         }
-        else if (is_integral(type_of(invoc))) {
+        else if (is_integral(t)) {
             return builder.CreateAdd(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFAdd(lhs, rhs);
         }
         else {
@@ -53,18 +59,18 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "-") {
-        if (is_pointer(type_of(invoc.args.front()))) {
-            if (is_integral(type_of(invoc.args.back()))) {
+        if (is_pointer(t)) {
+            if (is_integral(rhs_t)) {
                 return builder.CreateGEP(lhs, builder.CreateNeg(rhs));
             }
-            else if (is_pointer(type_of(invoc.args.back()))) {
+            else if (is_pointer(rhs_t)) {
                 return builder.CreatePtrDiff(lhs, rhs);
             }
         }
-        else if (is_integral(type_of(invoc))) {
+        else if (is_integral(t)) {
             return builder.CreateSub(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFSub(lhs, rhs);
         }
         else {
@@ -72,10 +78,10 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "*") {
-        if (is_integral(type_of(invoc))) {
+        if (is_integral(t)) {
             return builder.CreateMul(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFMul(lhs, rhs);
         }
         else {
@@ -83,13 +89,13 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "/") {
-        if (is_unsigned_integral(type_of(invoc))) {
+        if (is_unsigned_integral(t)) {
             return builder.CreateUDiv(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateSDiv(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFDiv(lhs, rhs);
         }
         else {
@@ -98,13 +104,13 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
     }
     else if (invoc.name == "%") {
         // TODO: remainder vs modulo
-        if (is_unsigned_integral(type_of(invoc))) {
+        if (is_unsigned_integral(t)) {
             return builder.CreateURem(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateSRem(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFRem(lhs, rhs);
         }
         else {
@@ -112,10 +118,10 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "=") {
-        if (is_integral_or_ptr(type_of(invoc))) {
+        if (is_integral_or_ptr(t)) {
             return builder.CreateICmpEQ(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpUEQ(lhs, rhs);
         }
         else {
@@ -123,10 +129,10 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "!=") {
-        if (is_integral_or_ptr(type_of(invoc))) {
+        if (is_integral_or_ptr(t)) {
             return builder.CreateICmpNE(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpUNE(lhs, rhs);
         }
         else {
@@ -134,13 +140,13 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "<") {
-        if (is_unsigned_or_ptr(type_of(invoc))) {
+        if (is_unsigned_or_ptr(t)) {
             return builder.CreateICmpULT(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateICmpSLT(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpULT(lhs, rhs);
         }
         else {
@@ -148,13 +154,13 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == "<=") {
-        if (is_unsigned_or_ptr(type_of(invoc))) {
+        if (is_unsigned_or_ptr(t)) {
             return builder.CreateICmpULE(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateICmpSLE(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpULE(lhs, rhs);
         }
         else {
@@ -162,13 +168,13 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == ">") {
-        if (is_unsigned_or_ptr(type_of(invoc))) {
+        if (is_unsigned_or_ptr(t)) {
             return builder.CreateICmpUGT(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateICmpSGT(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpUGT(lhs, rhs);
         }
         else {
@@ -176,37 +182,20 @@ llvm::Value* intrinsic_op(const Invocation& invoc, llvm::IRBuilder<>& builder, l
         }
     }
     else if (invoc.name == ">=") {
-        if (is_unsigned_or_ptr(type_of(invoc))) {
+        if (is_unsigned_or_ptr(t)) {
             return builder.CreateICmpUGE(lhs, rhs);
         }
-        else if (is_signed_integral(type_of(invoc))) {
+        else if (is_signed_integral(t)) {
             return builder.CreateICmpSGE(lhs, rhs);
         }
-        else if (is_floating_point(type_of(invoc))) {
+        else if (is_floating_point(t)) {
             return builder.CreateFCmpUGE(lhs, rhs);
         }
         else {
             assert(false);
         }
     }
-    else if (invoc.name == "&&") {
-        // TODO: short circuitating
-        if (type_of(invoc) == Intrinsics::boolean) {
-            return builder.CreateAnd(lhs, rhs);
-        }
-        else {
-            assert(false);
-        }
-    }
-    else if (invoc.name == "||") {
-        // TODO: short circuitating
-        if (type_of(invoc) == Intrinsics::boolean) {
-            return builder.CreateOr(lhs, rhs);
-        }
-        else {
-            assert(false);
-        }
-    }
+    // && and || short circuit, so they are lowered to branches by emit_expr
 
     return nullptr;
 }
\ No newline at end of file
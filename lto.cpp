@@ -0,0 +1,103 @@
+#include "lto.hpp"
+#include <iostream>
+#include <set>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/LTO/LTO.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+#include "object_emitter.hpp"
+#include "target.hpp"
+
+static bool error(const std::string& str) {
+    std::cerr << str << std::endl;
+    return false;
+}
+
+bool link_thin_lto(const std::vector<std::string>& inputs, const std::string& output,
+                   unsigned opt_level, bool native, unsigned jobs) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    // the same target as host_target_machine
+    llvm::lto::Config config;
+    config.DefaultTriple = llvm::sys::getDefaultTargetTriple();
+    config.CPU = native ? llvm::sys::getHostCPUName().str() : "generic";
+    if (native && !host_features().empty()) {
+        config.MAttrs = { host_features() };
+    }
+    config.RelocModel = llvm::Reloc::PIC_;
+    config.OptLevel = opt_level;
+    config.CGOptLevel = codegen_level(opt_level);
+    config.UseNewPM = true;
+
+    llvm::lto::LTO lto(std::move(config),
+                       llvm::lto::createInProcessThinBackend(llvm::heavyweight_hardware_concurrency(jobs)));
+
+    // the buffers must outlive the link
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> buffers;
+    std::set<std::string> defined;
+    for (const std::string& path : inputs) {
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if (!buffer) {
+            return error("could not open " + path + ": " + buffer.getError().message());
+        }
+        auto input = llvm::lto::InputFile::create((*buffer)->getMemBufferRef());
+        if (!input) {
+            llvm::logAllUnhandledErrors(input.takeError(), llvm::errs(), path + ": ");
+            return false;
+        }
+        buffers.push_back(std::move(*buffer));
+
+        // what a linker would decide: the first definition of a symbol wins, and
+        // nothing but main is used from outside the program
+        std::vector<llvm::lto::SymbolResolution> resolutions;
+        for (const llvm::lto::InputFile::Symbol& symbol : (*input)->symbols()) {
+            llvm::lto::SymbolResolution resolution;
+            if (!symbol.isUndefined()) {
+                resolution.Prevailing = defined.insert(symbol.getName().str()).second;
+                resolution.FinalDefinitionInLinkageUnit = true;
+            }
+            resolution.VisibleToRegularObj = symbol.getName() == "main";
+            resolutions.push_back(resolution);
+        }
+        if (llvm::Error e = lto.add(std::move(*input), resolutions)) {
+            llvm::logAllUnhandledErrors(std::move(e), llvm::errs(), path + ": ");
+            return false;
+        }
+    }
+
+    // one object per backend task, linked together by the system linker
+    std::vector<llvm::SmallString<128>> objects(lto.getMaxTasks());
+    auto add_stream = [&objects](unsigned task) -> std::unique_ptr<llvm::lto::NativeObjectStream> {
+        int fd;
+        if (llvm::sys::fs::createTemporaryFile("rhythm-lto", "o", fd, objects[task])) {
+            std::cerr << "could not create a temporary object file" << std::endl;
+            return nullptr;
+        }
+        return std::make_unique<llvm::lto::NativeObjectStream>(
+            std::make_unique<llvm::raw_fd_ostream>(fd, /* shouldClose */ true));
+    };
+    bool success = true;
+    if (llvm::Error e = lto.run(add_stream)) {
+        llvm::logAllUnhandledErrors(std::move(e), llvm::errs(), "link time optimization failed: ");
+        success = false;
+    }
+
+    std::vector<std::string> paths;
+    for (const auto& object : objects) {
+        if (!object.empty()) {
+            paths.push_back(object.str().str());
+        }
+    }
+    success = success && link_executable(paths, output);
+    for (const std::string& path : paths) {
+        llvm::sys::fs::remove(path);
+    }
+    return success;
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef LTO_HPP
+#define LTO_HPP
+
+#include <string>
+#include <vector>
+#include "llvm/IR/Module.h"
+
+// link bitcode files into an executable with ThinLTO: the summaries are
+// combined into a whole-program index, procedures are imported into the
+// modules that call them and each module is optimized at -O<opt_level> and
+// compiled on one of `jobs` threads. only `main` stays visible, everything
+// else may be inlined across modules and dropped. returns false (and says
+// why) on failure
+bool link_thin_lto(const std::vector<std::string>& inputs, const std::string& output,
+                   unsigned opt_level, bool native, unsigned jobs);
+
+#endif
\ No newline at end of file
@@ -1,55 +1,376 @@
+#include <algorithm>
 #include <iostream>
 #include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
 #include <unistd.h>
+#include "bitcode.hpp"
+#include "imports.hpp"
+#include "interface.hpp"
 #include "parse_tree.hpp"
 #include "print_tree.hpp"
 #include "type_system.hpp"
+#include "type_checker.hpp"
 #include "ir_emitter.hpp"
+#include "jit.hpp"
+#include "lto.hpp"
+#include "object_emitter.hpp"
+#include "optimizer.hpp"
+#include "parallel_emitter.hpp"
+#include "statistics.hpp"
+#include "target.hpp"
 
 // bison (yacc) setup requires pointers, will change in the future
 extern Block* program;
 extern int yyparse();
+extern FILE* yyin;
 
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [-O0|-O1|-O2|-O3] [-march=native] [-j jobs] [--run | -c | -S | --bitcode] [-o output]" << std::endl
+              << "       [--thin-lto] [-I dir] [--deps] [--interface-dir dir] [--emit-interface file] [--cache dir]" << std::endl
+              << "       [--time-passes] [--stats[=json]] [source.rh | module.bc...]" << std::endl
+              << "  reads source.rh (default: standard input) and writes LLVM IR to standard output." << std::endl
+              << "  bitcode modules are linked into one program instead" << std::endl
+              << "  -o file        write a native executable to file" << std::endl
+              << "  -c             write an object file (to -o, or source.o)" << std::endl
+              << "  -S             write an assembly file (to -o, or source.s)" << std::endl
+              << "  --bitcode      write LLVM bitcode (to -o, or standard output)" << std::endl
+              << "  --thin-lto     with --bitcode, write bitcode for a ThinLTO link. with bitcode" << std::endl
+              << "                 inputs and -o, link them with ThinLTO on -j threads" << std::endl
+              << "  -march=native  tune for and use every feature of the host cpu" << std::endl
+              << "  -j jobs        emit and optimize procedures on this many threads" << std::endl
+              << "  -I dir         also look for imported modules in dir" << std::endl
+              << "  --deps         list the files of all imported modules and exit" << std::endl
+              << "  --interface-dir dir   import modules from their interfaces in dir when up to date" << std::endl
+              << "  --emit-interface file write the interface of this module to file" << std::endl
+              << "  --cache dir    reuse the optimized code of unchanged procedures from dir" << std::endl
+              << "  --run          compile in memory and execute `main` instead of printing IR" << std::endl
+              << "  --time-passes  report the wall time of each compiler phase on standard error" << std::endl
+              << "  --stats[=json] report parse tree, symbol and per procedure instruction counts" << std::endl
+              << "                 on standard error, as text or json (with --time-passes, both)" << std::endl;
+}
 
+// source.rh -> source<extension>, standard input -> a<extension>
+std::string default_output(const char* source, const std::string& extension) {
+    std::string stem = source ? source : "a";
+    if (size_t dot = stem.rfind('.'); dot != std::string::npos && stem.find('/', dot) == std::string::npos) {
+        stem.erase(dot);
+    }
+    return stem + extension;
+}
 
 int main(int argc, char **argv)
 {
-    // why in the world is the initializer list not working
-    llvm_types[TypeSystem::Intrinsics::boolean] = llvm::Type::getInt8Ty   (context);
-    llvm_types[TypeSystem::Intrinsics::boolean] = llvm::Type::getInt8Ty   (context);
-    llvm_types[TypeSystem::Intrinsics::integer] = llvm::Type::getInt32Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::int8   ] = llvm::Type::getInt8Ty   (context);
-    llvm_types[TypeSystem::Intrinsics::int16  ] = llvm::Type::getInt16Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::int32  ] = llvm::Type::getInt32Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::int64  ] = llvm::Type::getInt64Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::natural] = llvm::Type::getInt32Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::nat8   ] = llvm::Type::getInt8Ty   (context);
-    llvm_types[TypeSystem::Intrinsics::nat16  ] = llvm::Type::getInt16Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::nat32  ] = llvm::Type::getInt32Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::nat64  ] = llvm::Type::getInt64Ty  (context);
-    llvm_types[TypeSystem::Intrinsics::float32] = llvm::Type::getFloatTy  (context);
-    llvm_types[TypeSystem::Intrinsics::float64] = llvm::Type::getDoubleTy (context);
-    llvm_types[TypeSystem::Intrinsics::void0  ] = llvm::Type::getVoidTy   (context);
-    // parse with bison (yacc)
-    yyparse();
-
-    // declare some c functions (e.g. printf)
-    cstdlib();
-
-    // generate LLVM IR
-    bool success = emit_stmt(*program);
-
-    if (!success) {
-        std::cerr << "failed to generate code" << std::endl;
+    unsigned opt_level = 0;
+    bool run = false;
+    bool native = false;
+    // what to write: IR to stdout unless -c, -S or -o ask for native code
+    enum { ir, object, assembly, executable, bitcode } emit = ir;
+    std::string output;
+    bool time_passes = false;
+    bool stats = false;
+    bool json = false;
+    unsigned jobs = 1;
+    std::vector<std::string> search_dirs;
+    bool deps = false;
+    bool thin_lto = false;
+    std::string cache_dir;
+    std::string interface_dir;
+    std::string interface_output;
+
+    const option long_options[] = {
+        { "run",         no_argument,       nullptr, 'r' },
+        { "march",       required_argument, nullptr, 'm' },
+        { "time-passes", no_argument,       nullptr, 't' },
+        { "stats",       optional_argument, nullptr, 's' },
+        { "deps",        no_argument,       nullptr, 'd' },
+        { "bitcode",     no_argument,       nullptr, 'b' },
+        { "thin-lto",    no_argument,       nullptr, 'l' },
+        { "cache",       required_argument, nullptr, 'k' },
+        { "interface-dir",  required_argument, nullptr, 'i' },
+        { "emit-interface", required_argument, nullptr, 'e' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    int opt;
+    // long_only so that gcc style -march=native parses
+    while ((opt = getopt_long_only(argc, argv, "O:cSo:j:I:", long_options, nullptr)) != -1) {
+        switch (opt) {
+        case 'O':
+            if (optarg[0] < '0' || optarg[0] > '3' || optarg[1] != '\0') {
+                usage(argv[0]);
+                return 1;
+            }
+            opt_level = optarg[0] - '0';
+            break;
+        case 'r':
+            run = true;
+            break;
+        case 'm':
+            if (std::string(optarg) != "native") {
+                std::cerr << "only -march=native is supported" << std::endl;
+                return 1;
+            }
+            native = true;
+            break;
+        case 't':
+            time_passes = true;
+            statistics.time_lexer = true;
+            break;
+        case 's':
+            if (optarg && std::string(optarg) != "json" && std::string(optarg) != "text") {
+                usage(argv[0]);
+                return 1;
+            }
+            stats = true;
+            json = optarg && std::string(optarg) == "json";
+            break;
+        case 'j':
+            jobs = std::atoi(optarg);
+            if (jobs < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'I':
+            search_dirs.push_back(optarg);
+            break;
+        case 'd':
+            deps = true;
+            break;
+        case 'k':
+            cache_dir = optarg;
+            break;
+        case 'i':
+            interface_dir = optarg;
+            break;
+        case 'e':
+            interface_output = optarg;
+            break;
+        case 'c':
+            emit = object;
+            break;
+        case 'S':
+            emit = assembly;
+            break;
+        case 'b':
+            emit = bitcode;
+            break;
+        case 'l':
+            thin_lto = true;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (emit == ir && !output.empty()) {
+        emit = executable;
+    }
+    // --run executes the program instead of writing or linking it
+    if (run && (emit != ir || thin_lto)) {
+        usage(argv[0]);
         return 1;
     }
 
-    // print to stdout
-    llvm::outs() << *module;
+    // one source file, or any number of bitcode files (see --bitcode) to link into one program
+    std::vector<std::string> bitcode_inputs(argv + optind, argv + argc);
+    bool all_bitcode = std::all_of(bitcode_inputs.begin(), bitcode_inputs.end(),
+        [](const std::string& input) { return llvm::StringRef(input).endswith(".bc"); });
+    if (!all_bitcode) {
+        if (bitcode_inputs.size() > 1) {
+            usage(argv[0]);
+            return 1;
+        }
+        bitcode_inputs.clear();
+    }
+    // read the program from a file so that stdin stays free for the program itself (--run)
+    const char* source = nullptr;
+    if (optind == argc - 1 && bitcode_inputs.empty()) {
+        source = argv[optind];
+        yyin = fopen(argv[optind], "r");
+        if (!yyin) {
+            std::cerr << "could not open " << argv[optind] << std::endl;
+            return 1;
+        }
+    }
 
-    if (llvm::verifyModule(*module, &llvm::errs())) {
+    if (thin_lto && !bitcode_inputs.empty()) {
+        if (emit != executable) {
+            std::cerr << "--thin-lto links bitcode into an executable (-o)" << std::endl;
+            return 1;
+        }
+        bool linked;
+        {
+            PhaseTimer timer("thin-lto");
+            linked = link_thin_lto(bitcode_inputs, output, opt_level, native, jobs);
+        }
+        if (time_passes || stats) {
+            print_statistics(std::cerr, time_passes, stats, json);
+        }
+        return linked ? 0 : 1;
+    }
+
+    // the whole program, emitted or read, ends up in `module`
+    bool parallel = false;
+    if (!bitcode_inputs.empty()) {
+        bool linked;
+        {
+            PhaseTimer timer("link");
+            linked = link_bitcode(*module, bitcode_inputs);
+        }
+        if (!linked) {
+            return 1;
+        }
+    }
+    else {
+        // parse with bison (yacc)
+        bool parsed;
+        {
+            PhaseTimer timer("parse");
+            parsed = yyparse() == 0 && load_imports(*program, source ? source : "", search_dirs, interface_dir);
+        }
+        if (!parsed) {
+            std::cerr << "syntax errors. compilation terminated" << std::endl;
+            return 1;
+        }
+        if (deps) {
+            for (const std::string& file : imported_files()) {
+                std::cout << file << std::endl;
+            }
+            return 0;
+        }
+        if (stats) {
+            count_nodes(*program);
+        }
+
+        // resolve the type of every expression once, up front
+        bool checked;
+        {
+            PhaseTimer timer("check");
+            checked = check_program(*program);
+        }
+        if (!checked) {
+            std::cerr << "type errors. compilation terminated" << std::endl;
+            return 1;
+        }
+        if (!interface_output.empty() && !write_interface(*program, interface_output)) {
+            return 1;
+        }
+
+        // declare some c functions (e.g. printf)
+        cstdlib();
+
+        // generate LLVM IR. in parallel or cached, each unit is also optimized on its own
+        bool cached = !cache_dir.empty() && parallelizable(*program);
+        parallel = cached || (jobs > 1 && parallelizable(*program));
+        bool success;
+        {
+            PhaseTimer timer(parallel ? "emit+optimize" : "emit");
+            success = cached   ? emit_cached(*program, cache_dir, jobs, opt_level, native, stats)
+                    : parallel ? emit_parallel(*program, jobs, opt_level, native, stats)
+                               : emit_program(*program);
+        }
+
+        if (!success) {
+            std::cerr << "failed to generate code" << std::endl;
+            return 1;
+        }
+        internalize(*program);
+    }
+
+    bool broken;
+    {
+        PhaseTimer timer("verify");
+        broken = llvm::verifyModule(*module, &llvm::errs());
+    }
+    if (broken) {
         std::cerr << "module failed to verify. compilation terminated" << std::endl;
         return 1;
     }
+    if (stats && !parallel) {
+        count_instructions(*module, false);
+    }
+
+    // optimize for the host so that target dependent passes have a cost model
+    std::unique_ptr<llvm::TargetMachine> target_machine;
+    {
+        PhaseTimer timer(parallel ? "target" : "optimize");
+        target_machine = host_target_machine(opt_level, native);
+        if (target_machine) {
+            set_target(*module, *target_machine);
+        }
+        if (!parallel) {
+            optimize(*module, opt_level, target_machine.get(), thin_lto && emit == bitcode);
+        }
+        else {
+            // the shares were optimized on their own, so calls of `inline`
+            // procedures from another share are only inlined once linked
+            optimize(*module, 0, target_machine.get());
+        }
+    }
+    if (stats && !parallel) {
+        count_instructions(*module, true);
+    }
+
+    auto report = [&] {
+        if (time_passes || stats) {
+            print_statistics(std::cerr, time_passes, stats, json);
+        }
+    };
+
+    if (run) {
+        // report before running, so the program's own time is not counted
+        report();
+        return run_jit(std::move(module), std::move(owned_context));
+    }
+
+    if (emit == bitcode) {
+        bool success;
+        {
+            PhaseTimer timer("write");
+            success = write_bitcode(*module, output.empty() ? "-" : output, thin_lto);
+        }
+        report();
+        return success ? 0 : 1;
+    }
+
+    if (emit != ir) {
+        if (!target_machine) {
+            return 1;
+        }
+
+        bool success = false;
+        {
+            PhaseTimer timer("codegen");
+            switch (emit) {
+            case object:
+                success = emit_native(*module, *target_machine,
+                                      output.empty() ? default_output(source, ".o") : output, llvm::CGFT_ObjectFile);
+                break;
+            case assembly:
+                success = emit_native(*module, *target_machine,
+                                      output.empty() ? default_output(source, ".s") : output, llvm::CGFT_AssemblyFile);
+                break;
+            default:
+                success = emit_executable(*module, *target_machine, output);
+                break;
+            }
+        }
+        report();
+        return success ? 0 : 1;
+    }
 
+    // print to stdout
+    {
+        PhaseTimer timer("print");
+        llvm::outs() << *module;
+        llvm::outs().flush();
+    }
+    report();
 }
\ No newline at end of file
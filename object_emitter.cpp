@@ -0,0 +1,62 @@
+#include "object_emitter.hpp"
+#include <iostream>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/raw_ostream.h"
+
+static bool error(const std::string& str) {
+    std::cerr << str << std::endl;
+    return false;
+}
+
+bool emit_native(llvm::Module& m, llvm::TargetMachine& tm,
+                 const std::string& path, llvm::CodeGenFileType type) {
+    std::error_code ec;
+    llvm::raw_fd_ostream dest(path, ec, llvm::sys::fs::OF_None);
+    if (ec) {
+        return error("could not open " + path + ": " + ec.message());
+    }
+
+    // the code generator still runs on the legacy pass manager
+    llvm::legacy::PassManager pm;
+    if (tm.addPassesToEmitFile(pm, dest, nullptr, type)) {
+        return error("target cannot emit a file of this type");
+    }
+    pm.run(m);
+    dest.flush();
+    return true;
+}
+
+bool link_executable(const std::vector<std::string>& objects, const std::string& output) {
+    // the c compiler driver knows where the system's crt objects and libc live
+    auto linker = llvm::sys::findProgramByName("cc");
+    if (!linker) {
+        return error("could not find the system linker driver `cc`");
+    }
+
+    std::vector<llvm::StringRef> args = { *linker };
+    args.insert(args.end(), objects.begin(), objects.end());
+    args.push_back("-o");
+    args.push_back(output);
+
+    std::string err;
+    int status = llvm::sys::ExecuteAndWait(*linker, args, llvm::None, {}, 0, 0, &err);
+    if (status != 0) {
+        return error("linking " + output + " failed" + (err.empty() ? "" : ": " + err));
+    }
+    return true;
+}
+
+bool emit_executable(llvm::Module& m, llvm::TargetMachine& tm, const std::string& output) {
+    llvm::SmallString<128> object_path;
+    if (llvm::sys::fs::createTemporaryFile("rhythm", "o", object_path)) {
+        return error("could not create a temporary object file");
+    }
+
+    bool success = emit_native(m, tm, object_path.str().str(), llvm::CGFT_ObjectFile)
+                && link_executable({ object_path.str().str() }, output);
+    llvm::sys::fs::remove(object_path);
+    return success;
+}
@@ -0,0 +1,21 @@
+#ifndef OBJECT_EMITTER_HPP
+#define OBJECT_EMITTER_HPP
+
+#include <string>
+#include <vector>
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+// write the module to path as an object file (llvm::CGFT_ObjectFile) or as
+// assembly (llvm::CGFT_AssemblyFile) using the target machine's code generator.
+// precondition: the module has the target machine's triple and data layout
+bool emit_native(llvm::Module& m, llvm::TargetMachine& tm,
+                 const std::string& path, llvm::CodeGenFileType type);
+
+// link object files (and the c library) into an executable with the system linker
+bool link_executable(const std::vector<std::string>& objects, const std::string& output);
+
+// compile the module to a temporary object file and link it into an executable
+bool emit_executable(llvm::Module& m, llvm::TargetMachine& tm, const std::string& output);
+
+#endif
@@ -0,0 +1,58 @@
+#include "optimizer.hpp"
+#include "llvm/Analysis/CGSCCPassManager.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
+
+static llvm::PassBuilder::OptimizationLevel pass_level(unsigned opt_level) {
+    switch (opt_level) {
+    case 1:  return llvm::PassBuilder::OptimizationLevel::O1;
+    case 2:  return llvm::PassBuilder::OptimizationLevel::O2;
+    default: return llvm::PassBuilder::OptimizationLevel::O3;
+    }
+}
+
+// rhythm code is written as many small generic procedures (successor,
+// accessors, comparisons) called from loops. clang's thresholds are 225 at
+// -O1 and -O2 and 250 at -O3. -O1 keeps them; -O2 and -O3 deliberately add
+// 100 to them (325 and 375), our own margin rather than a value from clang,
+// so that whole chains of such procedures collapse into their loop
+static int inliner_threshold(unsigned opt_level) {
+    switch (opt_level) {
+    case 1:  return 225;
+    case 2:  return 325;
+    default: return 375;
+    }
+}
+
+void optimize(llvm::Module& m, unsigned opt_level, llvm::TargetMachine* tm, bool thin_lto) {
+    llvm::LoopAnalysisManager     lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager    cgam;
+    llvm::ModuleAnalysisManager   mam;
+
+    llvm::PipelineTuningOptions tuning;
+    tuning.InlinerThreshold = inliner_threshold(opt_level);
+    llvm::PassBuilder pb(tm, tuning);
+    pb.registerModuleAnalyses  (mam);
+    pb.registerCGSCCAnalyses   (cgam);
+    pb.registerFunctionAnalyses(fam);
+    pb.registerLoopAnalyses    (lam);
+    pb.crossRegisterProxies(lam, fam, cgam, mam);
+
+    if (opt_level == 0) {
+        // nothing but `inline` procedures
+        llvm::ModulePassManager mpm;
+        mpm.addPass(llvm::AlwaysInlinerPass(/* InsertLifetimeIntrinsics */ false));
+        mpm.run(m, mam);
+        return;
+    }
+
+    // mem2reg (SROA), instcombine, GVN, loop rotation/LICM/unrolling, the inliner
+    // and the loop and SLP vectorizers are all part of the default pipeline.
+    // for ThinLTO, the late passes (e.g. vectorization) run after importing
+    llvm::ModulePassManager mpm = thin_lto ? pb.buildThinLTOPreLinkDefaultPipeline(pass_level(opt_level))
+                                           : pb.buildPerModuleDefaultPipeline(pass_level(opt_level));
+    mpm.run(m, mam);
+}
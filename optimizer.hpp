@@ -0,0 +1,13 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+// run the standard new pass manager pipeline for -O<opt_level> (0-3) over the module,
+// with the inliner tuned for small procedures. level 0 only inlines `inline` procedures.
+// with thin_lto, only the part of the pipeline that runs before a ThinLTO link. tm may be null, but then the target
+// dependent passes (e.g. the vectorizers) have no cost model to work with
+void optimize(llvm::Module& m, unsigned opt_level, llvm::TargetMachine* tm, bool thin_lto = false);
+
+#endif
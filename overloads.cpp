@@ -0,0 +1,121 @@
+#include "overloads.hpp"
+#include <mutex>
+#include <unordered_map>
+#include "generics.hpp"
+
+using namespace TypeSystem;
+
+namespace {
+
+struct Signature {
+    std::string name;
+    std::vector<TypeRef> types;
+};
+
+bool operator==(const Signature& lhs, const Signature& rhs) {
+    return lhs.name == rhs.name && lhs.types == rhs.types;
+}
+
+struct SignatureHash {
+    size_t operator()(const Signature& sig) const {
+        size_t h = std::hash<std::string>{}(sig.name);
+        for (TypeRef t : sig.types) {
+            h ^= std::hash<TypeRef>{}(t) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+struct Overload {
+    const Procedure* proc = nullptr;
+    // an instance of a generic procedure, which an ordinary overload declared
+    // later (e.g. in a nested block) replaces
+    bool instance = false;
+    // why calls with this signature are ambiguous, if they are
+    std::string ambiguity;
+};
+
+}
+
+static std::unordered_map<Signature, Overload, SignatureHash> overloads;
+// how many of procedure_definitions[name] are indexed. blocks add their
+// procedures as they are checked, so the index catches up on each lookup
+static std::unordered_map<std::string, size_t> indexed;
+// the emitters resolve calls from their threads. recursive because indexing
+// interns parameter types, whose sizes may call constexpr procedures
+static std::recursive_mutex mutex;
+
+static std::string describe(const std::string& name, const std::vector<TypeRef>& types) {
+    std::string s = name + "(";
+    for (size_t i = 0; i < types.size(); ++i) {
+        s += (i ? ", " : "") + types[i]->mangled;
+    }
+    return s + ")";
+}
+
+static void index(const std::string& name, const std::vector<const Procedure*>& procs) {
+    size_t& count = indexed[name];
+    while (count < procs.size()) {
+        const Procedure* proc = procs[count++];
+        if (!proc->type_parameters.empty()) {
+            continue;
+        }
+        Signature sig{name};
+        for (const Declaration& param : proc->parameters) {
+            sig.types.push_back(intern(param.type));
+        }
+        std::string description = describe(name, sig.types);
+        Overload& overload = overloads[std::move(sig)];
+        if (overload.proc && !overload.instance && overload.proc != proc) {
+            overload.ambiguity = "`" + description + "` is defined more than once";
+        }
+        else {
+            overload.proc = proc;
+            overload.instance = false;
+        }
+    }
+}
+
+const Procedure* resolve_overload(const std::string& name, const std::vector<TypeRef>& arg_types,
+                                  std::string* why) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto fail = [why](const std::string& reason) -> const Procedure* {
+        if (why) {
+            *why = reason;
+        }
+        return nullptr;
+    };
+
+    auto defs = procedure_definitions.find(name);
+    if (defs == procedure_definitions.end()) {
+        return fail("no such procedure `" + name + "`");
+    }
+    index(name, defs->second);
+
+    Signature sig{name, arg_types};
+    if (auto it = overloads.find(sig); it != overloads.end()) {
+        if (!it->second.ambiguity.empty()) {
+            return fail("call of `" + name + "` is ambiguous: " + it->second.ambiguity);
+        }
+        return it->second.proc;
+    }
+
+    // no ordinary overload: the generic procedure the arguments fit
+    const Procedure* generic = nullptr;
+    for (const Procedure* proc : defs->second) {
+        if (proc->type_parameters.empty() || !fits(*proc, arg_types)) {
+            continue;
+        }
+        if (generic) {
+            return fail("call of `" + name + "` is ambiguous: `" + describe(name, arg_types)
+                        + "` fits more than one generic procedure");
+        }
+        generic = proc;
+    }
+    if (!generic) {
+        return fail("could not find matching overload for `" + name + "`");
+    }
+    const Procedure* instance = instantiate(*generic, arg_types);
+    overloads.emplace(std::move(sig), Overload{instance, true});
+    return instance;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef OVERLOADS_HPP
+#define OVERLOADS_HPP
+
+#include <string>
+#include <vector>
+#include "parse_tree.hpp"
+#include "type_system.hpp"
+
+// overload resolution. the procedures of procedure_definitions are indexed by
+// their signature (name and parameter types), so resolving a call is one hash
+// lookup of its name and argument types. both the type checker and the
+// emitter resolve calls through here, so they always agree on the callee
+
+// the procedure called by `name` with arguments of these types: the ordinary
+// overload with exactly these parameter types, or else the instance of the
+// one generic procedure whose type parameters can be deduced from them (see
+// generics.hpp). returns nullptr and sets `why` if there is no such procedure
+// or the call is ambiguous: two overloads with the same parameter types, or
+// no ordinary overload and more than one generic procedure that fits
+const Procedure* resolve_overload(const std::string& name, const std::vector<TypeSystem::TypeRef>& arg_types,
+                                  std::string* why = nullptr);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "parallel_emitter.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Linker/Linker.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+#include "generics.hpp"
+#include "ir_emitter.hpp"
+#include "optimizer.hpp"
+#include "procedure_cache.hpp"
+#include "statistics.hpp"
+#include "symbol_table.hpp"
+#include "target.hpp"
+
+bool parallelizable(const Block& program) {
+    return std::all_of(program.statements.begin(), program.statements.end(),
+        [](const Statement& stmt) {
+            return std::holds_alternative<Procedure>(stmt.value) ||
+                   std::holds_alternative<Typedef>(stmt.value) ||
+                   std::holds_alternative<Import>(stmt.value);
+        });
+}
+
+// what a worker hands back. modules can't move between contexts, so the
+// optimized module is passed as bitcode and read back into the main context
+struct Share {
+    llvm::SmallVector<char, 0> bitcode;
+    std::vector<Statistics::Procedure> procedures;
+    size_t symbol_lookups = 0;
+    bool success = false;
+};
+
+// runs on a worker thread: `module`, `context` etc. are the worker's own
+static void emit_share(const Block& program, const std::vector<const Procedure*>& procs,
+                       size_t first, size_t limit, unsigned opt_level, bool native, bool stats,
+                       Share& share) {
+    cstdlib();
+    for (const Statement& stmt : program.statements) {
+        if (auto def = std::get_if<Typedef>(&stmt.value); def && !emit_stmt(*def)) {
+            return;
+        }
+        if (auto import = std::get_if<Import>(&stmt.value); import && !emit_stmt(*import)) {
+            return;
+        }
+    }
+    // calls into other shares resolve when the shares are linked
+    for (const Procedure* proc : procs) {
+        if (!declare_procedure(*proc)) {
+            return;
+        }
+    }
+    for (size_t i = first; i < limit; ++i) {
+        if (!emit_stmt(*procs[i])) {
+            return;
+        }
+    }
+
+    if (llvm::verifyModule(*module, &llvm::errs())) {
+        return;
+    }
+    if (stats) {
+        count_instructions(*module, false, share.procedures);
+    }
+
+    std::unique_ptr<llvm::TargetMachine> target_machine = host_target_machine(opt_level, native);
+    if (target_machine) {
+        set_target(*module, *target_machine);
+    }
+    optimize(*module, opt_level, target_machine.get());
+    if (stats) {
+        count_instructions(*module, true, share.procedures);
+    }
+
+    llvm::raw_svector_ostream os(share.bitcode);
+    llvm::WriteBitcodeToFile(*module, os);
+    share.symbol_lookups = symbol_lookups;
+    share.success = true;
+}
+
+// the program's procedures, then the instances of its generic procedures
+static std::vector<const Procedure*> procedures(const Block& program) {
+    std::vector<const Procedure*> procs;
+    for (const Statement& stmt : program.statements) {
+        if (auto proc = std::get_if<Procedure>(&stmt.value); proc && proc->type_parameters.empty()) {
+            procs.push_back(proc);
+        }
+    }
+    procs.insert(procs.end(), procedure_instances.begin(), procedure_instances.end());
+    return procs;
+}
+
+static std::unique_ptr<llvm::Module> read_share(const Share& share) {
+    llvm::StringRef bitcode(share.bitcode.data(), share.bitcode.size());
+    auto m = llvm::parseBitcodeFile(llvm::MemoryBufferRef(bitcode, "share"), context);
+    if (!m) {
+        llvm::logAllUnhandledErrors(m.takeError(), llvm::errs(), "could not read back emitted code: ");
+        return nullptr;
+    }
+    return std::move(*m);
+}
+
+static bool link_share(std::unique_ptr<llvm::Module> m) {
+    if (llvm::Linker::linkModules(*module, std::move(m))) {
+        std::cerr << "could not link emitted code" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool emit_parallel(const Block& program, unsigned jobs, unsigned opt_level, bool native, bool stats) {
+    std::vector<const Procedure*> procs = procedures(program);
+    jobs = std::max<size_t>(1, std::min<size_t>(jobs, procs.size()));
+
+    // target registration is not thread safe, the lookups in the workers are
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    std::vector<Share> shares(jobs);
+    std::vector<std::thread> workers;
+    for (unsigned j = 0; j < jobs; ++j) {
+        workers.emplace_back(emit_share, std::cref(program), std::cref(procs),
+                             procs.size() * j / jobs, procs.size() * (j + 1) / jobs,
+                             opt_level, native, stats, std::ref(shares[j]));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (Share& share : shares) {
+        if (!share.success) {
+            return false;
+        }
+        std::unique_ptr<llvm::Module> m = read_share(share);
+        if (!m || !link_share(std::move(m))) {
+            return false;
+        }
+        symbol_lookups += share.symbol_lookups;
+        statistics.procedures.insert(statistics.procedures.end(),
+                                     share.procedures.begin(), share.procedures.end());
+    }
+    return true;
+}
+
+bool emit_cached(const Block& program, const std::string& cache_dir, unsigned jobs,
+                 unsigned opt_level, bool native, bool stats) {
+    std::vector<const Procedure*> procs = procedures(program);
+    std::vector<std::unique_ptr<llvm::Module>> units(procs.size());
+    std::vector<std::string> keys;
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < procs.size(); ++i) {
+        keys.push_back(procedure_key(*procs[i], opt_level, native));
+        units[i] = load_cached(cache_dir, keys[i], context);
+        if (units[i]) {
+            if (stats) {
+                count_instructions(*units[i], true);
+            }
+        }
+        else {
+            misses.push_back(i);
+        }
+    }
+    statistics.cache_hits += procs.size() - misses.size();
+    statistics.cache_misses += misses.size();
+
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    // the emitter state is per thread, so every miss gets a fresh thread
+    std::vector<Share> shares(misses.size());
+    for (size_t first = 0; first < misses.size(); first += jobs) {
+        std::vector<std::thread> workers;
+        for (size_t k = first; k < std::min<size_t>(first + jobs, misses.size()); ++k) {
+            workers.emplace_back(emit_share, std::cref(program), std::cref(procs),
+                                 misses[k], misses[k] + 1, opt_level, native, stats,
+                                 std::ref(shares[k]));
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    for (size_t k = 0; k < misses.size(); ++k) {
+        Share& share = shares[k];
+        if (!share.success) {
+            return false;
+        }
+        // a cache that can't be written only costs time on the next compile
+        store_cached(cache_dir, keys[misses[k]],
+                     llvm::StringRef(share.bitcode.data(), share.bitcode.size()));
+        units[misses[k]] = read_share(share);
+        if (!units[misses[k]]) {
+            return false;
+        }
+        symbol_lookups += share.symbol_lookups;
+        statistics.procedures.insert(statistics.procedures.end(),
+                                     share.procedures.begin(), share.procedures.end());
+    }
+
+    // link in source order, hits and misses alike
+    for (auto& unit : units) {
+        if (!link_share(std::move(unit))) {
+            return false;
+        }
+    }
+    return true;
+}
\ No newline at end of file
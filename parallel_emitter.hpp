@@ -0,0 +1,28 @@
+#ifndef PARALLEL_EMITTER_HPP
+#define PARALLEL_EMITTER_HPP
+
+#include <string>
+#include "parse_tree.hpp"
+
+// true if the program only has procedures, typedefs and imports at the top level,
+// which is what emit_parallel can split up
+bool parallelizable(const Block& program);
+
+// emit and optimize the program's top level procedures on `jobs` threads.
+// each thread takes a contiguous share of the procedures and emits it, with
+// declarations of all the others, into a context and module of its own, then
+// runs the -O<opt_level> pipeline over that module. the shares are linked, in
+// source order, into this thread's `module`, so the output does not depend on
+// scheduling. a procedure is only inlined into callers in the same share.
+// precondition: parallelizable(program) and cstdlib() was emitted
+bool emit_parallel(const Block& program, unsigned jobs, unsigned opt_level, bool native, bool stats);
+
+// like emit_parallel, but every procedure is a share of its own, which is
+// reused from the cache in `cache_dir` when its key (procedure_key) is there.
+// the procedures that missed are emitted on up to `jobs` threads and stored.
+// a procedure is only inlined into itself.
+// precondition: parallelizable(program) and cstdlib() was emitted
+bool emit_cached(const Block& program, const std::string& cache_dir, unsigned jobs,
+                 unsigned opt_level, bool native, bool stats);
+
+#endif
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include "parse_tree.hpp"
 
-std::map<std::string, Declaration> variable_definitions;
-std::map<std::string, std::vector<Procedure>> procedure_definitions;
+#include "arena.hpp"
+
+Arena parse_arena;
+
+std::map<std::string, std::vector<const Procedure*>> procedure_definitions;
+std::map<std::string, const Type*> type_definitions;
 
 // equality
 bool operator==(const Type& lhs, const Type& rhs) {
@@ -14,7 +18,7 @@ bool operator==(const Literal& lhs, const Literal& rhs) {
 }
 
 bool operator==(const Variable& lhs, const Variable& rhs) {
-    return lhs.name == rhs.name;
+    return lhs.id == rhs.id;
 }
 
 bool operator==(const Invocation& lhs, const Invocation& rhs) {
@@ -38,7 +42,9 @@ bool operator==(const Block& lhs, const Block& rhs) {
 bool operator==(const Declaration& lhs, const Declaration& rhs) {
     return lhs.variable == rhs.variable &&
            lhs.type == rhs.type &&
-           lhs.initializer == rhs.initializer;
+           lhs.initializer == rhs.initializer &&
+           lhs.noalias == rhs.noalias &&
+           lhs.constant == rhs.constant;
 }
 
 bool operator==(const Import& lhs, const Import& rhs) {
@@ -51,16 +57,25 @@ bool operator==(const Conditional& lhs, const Conditional& rhs) {
            lhs.else_block == rhs.else_block;
 }
 
+bool operator==(const LoopHints& lhs, const LoopHints& rhs) {
+    return lhs.vectorize_width == rhs.vectorize_width &&
+           lhs.unroll_count == rhs.unroll_count &&
+           lhs.independent == rhs.independent;
+}
+
 bool operator==(const WhileLoop& lhs, const WhileLoop& rhs) {
     return lhs.condition == rhs.condition &&
-           lhs.block == rhs.block;
+           lhs.block == rhs.block &&
+           lhs.hints == rhs.hints;
 }
 
 bool operator==(const Procedure& lhs, const Procedure& rhs) {
     return lhs.name == rhs.name &&
            lhs.parameters == rhs.parameters &&
            lhs.return_type == rhs.return_type &&
-           lhs.block == rhs.block;
+           lhs.block == rhs.block &&
+           lhs.attributes == rhs.attributes &&
+           lhs.type_parameters == rhs.type_parameters;
 }
 
 bool operator==(const Return& lhs, const Return& rhs) {
@@ -95,6 +110,10 @@ bool operator<(const Variable& lhs, const Variable& rhs) {
 }
 
 // others
+bool external_linkage(const Procedure& proc) {
+    return (proc.attributes & Procedure::exported) || proc.name == "main";
+}
+
 std::string to_string(const Type& t) {
     if (t.parameters.empty()) {
         return t.name;
@@ -109,9 +128,13 @@ std::string to_string(const Type& t) {
         else if (std::holds_alternative<Declaration>(p)) {
             name += to_string(std::get<Declaration>(p).type);
         }
-        else {
+        else if (std::holds_alternative<size_t>(p)) {
             name += std::to_string(std::get<size_t>(p));
         }
+        else {
+            // not folded yet (see check_program), so the size isn't known
+            name += "(size)";
+        }
     }
 
     name += ".";
@@ -7,12 +7,21 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include "symbol_table.hpp"
 
 struct Declaration;
 
+namespace TypeSystem {
+struct TypeInfo;
+}
+
+struct Expression;
+
+// a type as written in the source. see TypeSystem::intern for its canonical form.
+// sizes are literals or constant expressions owned by the parse arena
 struct Type {
     std::string name;
-    std::vector<std::variant<Type, size_t, Declaration>> parameters;
+    std::vector<std::variant<Type, size_t, Declaration, Expression*>> parameters;
 };
 
      /*------------.
@@ -27,6 +36,9 @@ struct Literal {
 
 struct Variable {
     std::string name;
+    Identifier id;
+    // resolved by the type checker according to scope
+    const Declaration* declaration = nullptr;
 };
 
 struct Invocation {
@@ -36,11 +48,14 @@ struct Invocation {
 
 struct TypeCast {
     Type type;
-    std::shared_ptr<Expression> expr;
+    // owned by the parse arena
+    Expression* expr;
 };
 
 struct Expression {
     std::variant<Literal, Variable, Invocation, TypeCast> value;
+    // resolved once by the type checker (check_stmt), then read by TypeSystem::type_of
+    const TypeSystem::TypeInfo* type = nullptr;
 };
 
      /*-----------.
@@ -56,10 +71,20 @@ struct Declaration {
     Variable variable;
     Type type;
     std::optional<Expression> initializer;
+    // parameters only, `noalias p Pointer(T)`: while the procedure runs, what
+    // p points to is only accessed through p
+    bool noalias = false;
+    // `let name T <- value`: read-only, initialized with constant data
+    bool constant = false;
+    // resolved by the type checker: declared outside of any procedure, so it
+    // is stored in a global variable
+    bool global = false;
 };
 
 struct Import {
     std::string identifier;
+    // the parsed module, resolved by load_imports
+    const Block* module = nullptr;
 };
 
 struct Conditional {
@@ -68,16 +93,41 @@ struct Conditional {
     Block else_block;
 };
 
+// written before `while`, e.g. `vectorize(8) unroll(2) independent while`.
+// 0 leaves the choice to the optimizer
+struct LoopHints {
+    unsigned vectorize_width = 0; // vectorize(width), 1 disables vectorization
+    unsigned unroll_count = 0;    // unroll(n), 1 disables unrolling
+    bool independent = false;     // independent: no iteration depends on another's memory accesses
+};
+
 struct WhileLoop {
     Expression condition;
     Block block;
+    LoopHints hints;
 };
 
 struct Procedure {
+    // written before `proc`, e.g. `export inline proc`
+    enum Attributes : unsigned {
+        always_inline = 1 << 0, // inline
+        never_inline  = 1 << 1, // noinline
+        exported      = 1 << 2, // export: visible to importing modules
+        constant      = 1 << 3, // constexpr: may be evaluated at compile time
+    };
+
     std::string name;
     std::vector<Declaration> parameters;
     Type return_type;
     Block block;
+    unsigned attributes = 0;
+    // linkage name, for procedures imported from a module interface. empty
+    // for procedures in source, whose linkage name is their decorate_name
+    std::string symbol;
+    // `proc copy[T](...)`: a generic procedure, which is not checked or
+    // emitted itself but instantiated for each set of argument types it is
+    // called with (see generics.hpp)
+    std::vector<std::string> type_parameters;
 };
 
 struct Return {
@@ -94,8 +144,9 @@ struct Statement {
         Conditional, WhileLoop, Procedure, Return, Typedef> value;
 };
 
-extern std::map<std::string, Declaration> variable_definitions;
-extern std::map<std::string, std::vector<Procedure>>  procedure_definitions;
+// definitions by name, pointing into the parse tree. filled in by the type checker
+extern std::map<std::string, std::vector<const Procedure*>> procedure_definitions;
+extern std::map<std::string, const Type*> type_definitions;
 
 
 // provide equality operator to make parse tree types regular
@@ -110,6 +161,7 @@ bool operator==(const Block       & lhs, const Block       & rhs);
 bool operator==(const Declaration & lhs, const Declaration & rhs);
 bool operator==(const Import      & lhs, const Import      & rhs);
 bool operator==(const Conditional & lhs, const Conditional & rhs);
+bool operator==(const LoopHints   & lhs, const LoopHints   & rhs);
 bool operator==(const WhileLoop   & lhs, const WhileLoop   & rhs);
 bool operator==(const Procedure   & lhs, const Procedure   & rhs);
 bool operator==(const Return      & lhs, const Return      & rhs);
@@ -123,6 +175,10 @@ bool operator<(const Type        & lhs, const Type        & rhs);
 bool operator<(const Declaration & lhs, const Declaration & rhs);
 bool operator<(const Variable    & lhs, const Variable    & rhs);
 
+// exported procedures and main can be called from outside their module,
+// all others get internal linkage
+bool external_linkage(const Procedure& proc);
+
 // convert type to string for name decoration for function overloading
 std::string to_string(const Type& t);
 
@@ -4,20 +4,36 @@
     #include <string>
     #include <variant>
     #include <map>
+    #include "arena.hpp"
     #include "parse_tree.hpp"
     #include "parser.hpp"
-    #include "type_system.hpp"
-    extern int yylex();
+    #include "statistics.hpp"
+    extern int lex_token();
     int line_num = 1;
     void yyerror(const char *s) { printf("ERROR: %s (line %i)\n", s, line_num); }
     Block* program;
 
+    // bison pulls tokens while parsing, so lexing time is moved out of the parse phase here
+    int yylex() {
+        ++statistics.tokens;
+        if (!statistics.time_lexer) {
+            return lex_token();
+        }
+        auto start = std::chrono::steady_clock::now();
+        int token = lex_token();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        statistics.add_time("lex", elapsed.count());
+        statistics.add_time("parse", -elapsed.count());
+        return token;
+    }
+
     std::map<int, std::string> op_to_string = {
         {TOKEN_PLUS, "+"},
         {TOKEN_MINUS, "-"},
         {TOKEN_STAR, "*"},
         {TOKEN_SLASH, "/"},
         {TOKEN_EQ, "="},
+        {TOKEN_NE, "!="},
         {TOKEN_LT, "<"},
         {TOKEN_LE, "<="},
         {TOKEN_GT, ">"},
@@ -29,14 +45,21 @@
         {TOKEN_OR, "||"}
     };
 
+    // semantic values are owned by parse_arena and are moved, never copied,
+    // into their parent nodes. the arena frees them all at once
     Expression* operator_to_invocation(int op_token, Expression* expr1, Expression* expr2 = nullptr) {
         std::string name = op_to_string[op_token];
         std::vector<Expression> args;
-        args.push_back(*expr1);
+        args.push_back(std::move(*expr1));
         if (expr2) {
-            args.push_back(*expr2);
+            args.push_back(std::move(*expr2));
         }
-        return new Expression{Invocation{name, args}};
+        return parse_arena.make<Expression>(Invocation{std::move(name), std::move(args)});
+    }
+
+    Variable make_variable(std::string&& name) {
+        Identifier id = intern_identifier(name);
+        return Variable{std::move(name), id};
     }
 %}
 
@@ -47,12 +70,14 @@
     Declaration* declaration;
     std::vector<Declaration>* decl_list;
     std::vector<Expression>* input;
-    std::variant<Type, size_t, Declaration>* type_param;
-    std::vector<std::variant<Type, size_t, Declaration>>* type_param_list;
+    std::variant<Type, size_t, Declaration, Expression*>* type_param;
+    std::vector<std::variant<Type, size_t, Declaration, Expression*>>* type_param_list;
     Import* import;
     Conditional* conditional;
     WhileLoop* while_loop;
+    LoopHints* loop_hints;
     Procedure* procedure;
+    std::vector<std::string>* names;
     Return* return_stmt;
     Typedef* type_def;
     Statement* statement;
@@ -71,12 +96,15 @@
 /* keywords */
 %token <token> TOKEN_RETURN TOKEN_IF TOKEN_WHILE TOKEN_DO TOKEN_TYPEDEF
 %token <token> TOKEN_PROC TOKEN_IMPORT TOKEN_LET TOKEN_TRUE TOKEN_FALSE
+%token <token> TOKEN_INLINE TOKEN_NOINLINE TOKEN_EXPORT TOKEN_NOALIAS TOKEN_CONSTEXPR
+%token <token> TOKEN_VECTORIZE TOKEN_UNROLL TOKEN_INDEPENDENT
 
 %type <type> type
 %type <type_param_list> type_param_list
 %type <type_param> type_param
 
 %type <token> or and eq relate add multiply pre
+%type <token> attributes
 
 %type <input> expr_list
 %type <literal> literal
@@ -86,10 +114,12 @@
 
 %type <import> import
 %type <invocation> invocation
-%type <declaration> declaration
+%type <declaration> declaration parameter
 %type <conditional> conditional
 %type <while_loop> while_stmt
+%type <loop_hints> loop_hints
 %type <procedure> procedure
+%type <names> type_parameters type_name_list
 %type <decl_list> parameters decl_list
 %type <return_stmt> return_stmt
 %type <type_def> type_def
@@ -114,72 +144,66 @@ program         : block
 block           : statement_list
                 | statement
                     {
-                        $$ = new Block{};
-                        $$->statements.push_back(*$1);
+                        $$ = parse_arena.make<Block>();
+                        $$->statements.push_back(std::move(*$1));
                     }
                 ;
 
 statement_list  : statement eol
                     {
-                        $$ = new Block{};
-                        $$->statements.push_back(*$1);
+                        $$ = parse_arena.make<Block>();
+                        $$->statements.push_back(std::move(*$1));
                     }
                 | statement_list statement eol
                     {
                         $$ = $1;
-                        $$->statements.push_back(*$2);
+                        $$->statements.push_back(std::move(*$2));
                     }
-                | eol { $$ = new Block(); }
+                | eol { $$ = parse_arena.make<Block>(); }
                 ;
 
-statement       : expression  { $$ = new Statement{*$1}; }
-                | declaration { $$ = new Statement{*$1}; }
-                | assignment  { $$ = new Statement{*$1}; }
-                | import      { $$ = new Statement{*$1}; }
-                | type_def    { $$ = new Statement{*$1}; delete $1; }
+statement       : expression  { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | declaration { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | TOKEN_LET declaration
+                    {
+                        $2->constant = true;
+                        $$ = parse_arena.make<Statement>(std::move(*$2));
+                    }
+                | assignment  { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | import      { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | type_def    { $$ = parse_arena.make<Statement>(std::move(*$1)); }
                 | control
                 ;
 
 expr_list       : expression
                     {
-                        $$ = new std::vector<Expression>({*$1});
-                        delete $1;
+                        $$ = parse_arena.make<std::vector<Expression>>();
+                        $$->push_back(std::move(*$1));
                     }
                 | expr_list TOKEN_COMMA expression
                     {
                         $$ = $1;
-                        $$->push_back(*$3);
-                        delete $3;
+                        $$->push_back(std::move(*$3));
                     }
                 ;
 
 invocation      : TOKEN_IDENT TOKEN_LPAREN expr_list TOKEN_RPAREN
                     {
-                        $$ = new Invocation{*$1, std::move(*$3)};
-                        delete $1;
-                        delete $3;
+                        $$ = parse_arena.make<Invocation>(std::move(*$1), std::move(*$3));
                     }
                 | TOKEN_IDENT TOKEN_LPAREN TOKEN_RPAREN
                     {
-                        $$ = new Invocation{*$1, {}};
-                        delete $1;
+                        $$ = parse_arena.make<Invocation>(std::move(*$1));
                     }
                 ;
 
 declaration     : TOKEN_IDENT type
                     {
-                        $$ = new Declaration{*$1, Type{*$2}};
-                        variable_definitions[*$1] = *$$;
-                        delete $1;
-                        delete $2;
+                        $$ = parse_arena.make<Declaration>(make_variable(std::move(*$1)), std::move(*$2));
                     }
                 | TOKEN_IDENT type TOKEN_LARROW expression
                     {
-                        $$ = new Declaration{*$1, Type{*$2}, *$4};
-                        variable_definitions[*$1] = *$$;
-                        delete $1;
-                        delete $2;
-                        delete $4;
+                        $$ = parse_arena.make<Declaration>(make_variable(std::move(*$1)), std::move(*$2), std::move(*$4));
                     }
                 ;
 
@@ -189,77 +213,118 @@ assignment      : expression TOKEN_LARROW expression
                     }
                 ;
 
-control         : return_stmt { $$ = new Statement{*$1}; delete $1; }
-                | conditional { $$ = new Statement{*$1}; delete $1; }
-                | while_stmt { $$ = new Statement{*$1}; delete $1; }
-                | procedure { $$ = new Statement{*$1}; delete $1; }
+control         : return_stmt { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | conditional { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | while_stmt  { $$ = parse_arena.make<Statement>(std::move(*$1)); }
+                | procedure   { $$ = parse_arena.make<Statement>(std::move(*$1)); }
                 ;
 
-return_stmt     : TOKEN_RETURN { $$ = new Return{}; }
-                | TOKEN_RETURN expression { $$ = new Return{*$2}; delete $2; }
+return_stmt     : TOKEN_RETURN { $$ = parse_arena.make<Return>(); }
+                | TOKEN_RETURN expression { $$ = parse_arena.make<Return>(std::move(*$2)); }
                 ;
 
 conditional     : TOKEN_IF expression TOKEN_LBRACE block TOKEN_RBRACE
                     {
-                        $$ = new Conditional{*$2, *$4};
-                        delete $2;
-                        delete $4;
+                        $$ = parse_arena.make<Conditional>(std::move(*$2), std::move(*$4));
                     }
                 ;
 
-while_stmt      : TOKEN_WHILE expression TOKEN_LBRACE block TOKEN_RBRACE
+while_stmt      : loop_hints TOKEN_WHILE expression TOKEN_LBRACE block TOKEN_RBRACE
                     {
-                        $$ = new WhileLoop{*$2, std::move(*$4)};
-                        delete $2;
-                        delete $4;
+                        $$ = parse_arena.make<WhileLoop>(std::move(*$3), std::move(*$5), *$1);
                     }
                 ;
 
-procedure       : TOKEN_PROC TOKEN_IDENT parameters type TOKEN_LBRACE block TOKEN_RBRACE
+loop_hints      : /* empty */ { $$ = parse_arena.make<LoopHints>(); }
+                | loop_hints TOKEN_VECTORIZE TOKEN_LPAREN TOKEN_INT TOKEN_RPAREN
                     {
-                        $$ = new Procedure{*$2, std::move(*$3), *$4, std::move(*$6)};
-                        procedure_definitions[*$2].emplace_back(*$$);
-                        delete $2;
-                        delete $3;
-                        delete $4;
-                        delete $6;
+                        $$ = $1;
+                        $$->vectorize_width = (unsigned) atoll($4->c_str());
+                    }
+                | loop_hints TOKEN_UNROLL TOKEN_LPAREN TOKEN_INT TOKEN_RPAREN
+                    {
+                        $$ = $1;
+                        $$->unroll_count = (unsigned) atoll($4->c_str());
                     }
-                | TOKEN_PROC TOKEN_IDENT parameters TOKEN_LBRACE block TOKEN_RBRACE
+                | loop_hints TOKEN_INDEPENDENT
+                    {
+                        $$ = $1;
+                        $$->independent = true;
+                    }
+                ;
+
+procedure       : attributes TOKEN_PROC TOKEN_IDENT type_parameters parameters type TOKEN_LBRACE block TOKEN_RBRACE
+                    {
+                        $$ = parse_arena.make<Procedure>(std::move(*$3), std::move(*$5), std::move(*$6), std::move(*$8));
+                        $$->attributes = $1;
+                        $$->type_parameters = std::move(*$4);
+                    }
+                | attributes TOKEN_PROC TOKEN_IDENT type_parameters parameters TOKEN_LBRACE block TOKEN_RBRACE
                     {
                         // void procedure
-                        $$ = new Procedure{*$2, std::move(*$3), TypeSystem::Intrinsics::void0, std::move(*$5)};
-                        procedure_definitions[*$2].emplace_back(*$$);
-                        delete $2;
-                        delete $3;
-                        delete $5;
+                        $$ = parse_arena.make<Procedure>(std::move(*$3), std::move(*$5), Type{"Void"}, std::move(*$7));
+                        $$->attributes = $1;
+                        $$->type_parameters = std::move(*$4);
                     }
                 ;
 
-parameters      : TOKEN_LPAREN TOKEN_RPAREN { $$ = new std::vector<Declaration>(); }
+type_parameters : /* empty */ { $$ = parse_arena.make<std::vector<std::string>>(); }
+                | TOKEN_LBRACK type_name_list TOKEN_RBRACK
+                    {
+                        $$ = $2;
+                    }
+                ;
+
+type_name_list  : TOKEN_TYPE
+                    {
+                        $$ = parse_arena.make<std::vector<std::string>>();
+                        $$->push_back(std::move(*$1));
+                    }
+                | type_name_list TOKEN_COMMA TOKEN_TYPE
+                    {
+                        $$ = $1;
+                        $$->push_back(std::move(*$3));
+                    }
+                ;
+
+attributes      : /* empty */ { $$ = 0; }
+                | attributes TOKEN_INLINE   { $$ = $1 | Procedure::always_inline; }
+                | attributes TOKEN_NOINLINE { $$ = $1 | Procedure::never_inline; }
+                | attributes TOKEN_EXPORT   { $$ = $1 | Procedure::exported; }
+                | attributes TOKEN_CONSTEXPR { $$ = $1 | Procedure::constant; }
+                ;
+
+parameters      : TOKEN_LPAREN TOKEN_RPAREN { $$ = parse_arena.make<std::vector<Declaration>>(); }
                 | TOKEN_LPAREN decl_list TOKEN_RPAREN
                     {
                         $$ = $2;
                     }
                 ;
 
-decl_list       : declaration
+parameter       : declaration
+                | TOKEN_NOALIAS declaration
+                    {
+                        $$ = $2;
+                        $$->noalias = true;
+                    }
+                ;
+
+decl_list       : parameter
                     {
-                        $$ = new std::vector<Declaration>();
-                        $$->push_back(*$1);
-                        delete $1;
+                        $$ = parse_arena.make<std::vector<Declaration>>();
+                        $$->push_back(std::move(*$1));
                     }
-                | decl_list TOKEN_COMMA declaration
+                | decl_list TOKEN_COMMA parameter
                     {
                         $$ = $1;
-                        $$->push_back(*$3);
-                        delete $3;
+                        $$->push_back(std::move(*$3));
                     }
                 ;
 
 import          : TOKEN_IMPORT TOKEN_TYPE
-                    { $$ = new Import{*$2}; delete $2; }
+                    { $$ = parse_arena.make<Import>(std::move(*$2)); }
                 | TOKEN_IMPORT TOKEN_IDENT
-                    { $$ = new Import{*$2}; delete $2; }
+                    { $$ = parse_arena.make<Import>(std::move(*$2)); }
 
 
 
@@ -316,63 +381,64 @@ prefix          : primary
                     }
                 ;
 
-primary         : literal { $$ = new Expression{*$1}; delete $1; }
-                | TOKEN_IDENT { $$ = new Expression{Variable{*$1}}; delete $1; }
-                | invocation { $$ = new Expression{*$1}; delete $1; }
+primary         : literal { $$ = parse_arena.make<Expression>(std::move(*$1)); }
+                | TOKEN_IDENT { $$ = parse_arena.make<Expression>(make_variable(std::move(*$1))); }
+                | invocation { $$ = parse_arena.make<Expression>(std::move(*$1)); }
+                | TOKEN_LBRACK expr_list TOKEN_RBRACK {
+                    // an array literal, see evaluate_initializer
+                    $$ = parse_arena.make<Expression>(Invocation{"[]", std::move(*$2)});
+                }
                 | TOKEN_LPAREN expression TOKEN_RPAREN {
                     $$ = $2;
                 }
                 | TOKEN_TYPE TOKEN_BANG expression {
-                    // type cast takes ownership of expression
-                    $$ = new Expression{TypeCast{Type{*$1}, std::shared_ptr<Expression>($3)}};
-                    delete $1;
+                    // the cast refers to the arena owned expression
+                    $$ = parse_arena.make<Expression>(TypeCast{Type{std::move(*$1)}, $3});
                 }
                 ;
 
 type_param      : type {
-                    $$ = new std::variant<Type, size_t, Declaration>(Type{*$1});
-                    delete $1;
+                    $$ = parse_arena.make<std::variant<Type, size_t, Declaration, Expression*>>(std::move(*$1));
                 }
                 | TOKEN_INT {
-                    $$ = new std::variant<Type, size_t, Declaration>(size_t{(size_t) atoll($1->c_str())});
-                    delete $1;
+                    $$ = parse_arena.make<std::variant<Type, size_t, Declaration, Expression*>>(size_t{(size_t) atoll($1->c_str())});
                 }
                 | declaration {
-                    $$ = new std::variant<Type, size_t, Declaration>(Declaration{*$1});
-                    delete $1;
+                    $$ = parse_arena.make<std::variant<Type, size_t, Declaration, Expression*>>(std::move(*$1));
+                }
+                | TOKEN_LPAREN expression TOKEN_RPAREN {
+                    // a constant size, evaluated when the type is interned
+                    $$ = parse_arena.make<std::variant<Type, size_t, Declaration, Expression*>>($2);
+                }
+                | invocation {
+                    Expression* expr = parse_arena.make<Expression>(std::move(*$1));
+                    $$ = parse_arena.make<std::variant<Type, size_t, Declaration, Expression*>>(expr);
                 }
                 ;
 
 type_param_list : type_param {
-                    $$ = new std::vector<std::variant<Type, size_t, Declaration>>{*$1};
-                    delete $1;
+                    $$ = parse_arena.make<std::vector<std::variant<Type, size_t, Declaration, Expression*>>>();
+                    $$->push_back(std::move(*$1));
                 }
                 | type_param_list TOKEN_COMMA type_param {
                     $$ = $1;
-                    $1->push_back(*$3);
-                    delete $3;
+                    $1->push_back(std::move(*$3));
                 }
                 ;
 
 type            : TOKEN_TYPE { 
-                    $$ = new Type{*$1};
-                    delete $1; 
+                    $$ = parse_arena.make<Type>(std::move(*$1));
                 }
                 | TOKEN_TYPE TOKEN_LPAREN type_param_list TOKEN_RPAREN {
-                    $$ = new Type{*$1, std::move(*$3)};
-                    delete $1;
-                    delete $3;
+                    $$ = parse_arena.make<Type>(std::move(*$1), std::move(*$3));
                 }
                 | TOKEN_TYPE TOKEN_LPAREN TOKEN_RPAREN {
-                    $$ = new Type{*$1, {}};
-                    delete $1;
+                    $$ = parse_arena.make<Type>(std::move(*$1));
                 }
                 ;
 
 type_def        : TOKEN_TYPEDEF TOKEN_TYPE type {
-                    $$ = new Typedef{*$2, *$3};
-                    delete $2;
-                    delete $3;
+                    $$ = parse_arena.make<Typedef>(std::move(*$2), std::move(*$3));
                 }
                 ;
 
@@ -387,24 +453,21 @@ pre : TOKEN_BANG | TOKEN_MINUS;
 
 literal : TOKEN_INT
             {
-                $$ = new Literal{*$1, Literal::integer};
-                delete $1;
+                $$ = parse_arena.make<Literal>(std::move(*$1), Literal::integer);
             }
         | TOKEN_REAL
             {
-                $$ = new Literal{*$1, Literal::rational};
-                delete $1;
+                $$ = parse_arena.make<Literal>(std::move(*$1), Literal::rational);
             }
         | TOKEN_STR
             {
-                $$ = new Literal{*$1, Literal::string};
+                $$ = parse_arena.make<Literal>(std::move(*$1), Literal::string);
                 // TODO: add other escape sequences
                 size_t i = $$->value.find("\\n"); 
                 while (i != std::string::npos) {
                     $$->value.replace(i, 2, "\n");
                     i = $$->value.find("\\n"); 
                 }
-                delete $1;
             }
         ;
 eol : TOKEN_EOL { ++line_num; } | eol TOKEN_EOL { ++line_num; };
@@ -0,0 +1,242 @@
+#include "procedure_cache.hpp"
+#include <iostream>
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+// bump whenever the emitter or optimizer change the code they produce,
+// so entries written by an older rhythmc are not reused
+static const char* cache_version = "rhythm-cache-3";
+
+// hashing
+// -------
+// every node hashes a tag before its children, and strings their length,
+// so that different trees never feed the same bytes
+static void hash(llvm::MD5& md5, llvm::StringRef s) {
+    md5.update(std::to_string(s.size()) + ":");
+    md5.update(s);
+}
+
+static void hash(llvm::MD5& md5, size_t n) {
+    hash(md5, llvm::StringRef(std::to_string(n)));
+}
+
+static void hash(llvm::MD5& md5, const Expression& expr);
+static void hash(llvm::MD5& md5, const Block& block);
+static void hash(llvm::MD5& md5, const Declaration& decl);
+
+static void hash(llvm::MD5& md5, const Type& type) {
+    hash(md5, llvm::StringRef(type.name));
+    hash(md5, type.parameters.size());
+    for (const auto& param : type.parameters) {
+        if (auto t = std::get_if<Type>(&param)) {
+            hash(md5, "type");
+            hash(md5, *t);
+        }
+        // the type checker folded constant size expressions, so the key
+        // changes with the constexpr procedures a size calls
+        else if (auto n = std::get_if<size_t>(&param)) {
+            hash(md5, "size");
+            hash(md5, *n);
+        }
+        else {
+            // struct fields: their names decide the field indices
+            hash(md5, "field");
+            hash(md5, std::get<Declaration>(param));
+        }
+    }
+}
+
+static void hash(llvm::MD5& md5, const Literal& lit) {
+    hash(md5, "literal");
+    hash(md5, size_t(lit.type));
+    hash(md5, llvm::StringRef(lit.value));
+}
+
+static void hash(llvm::MD5& md5, const Variable& var) {
+    // by name: identifiers are interned in a different order every run
+    hash(md5, "variable");
+    hash(md5, llvm::StringRef(var.name));
+}
+
+static void hash(llvm::MD5& md5, const Invocation& invoc) {
+    hash(md5, "invocation");
+    hash(md5, llvm::StringRef(invoc.name));
+    hash(md5, invoc.args.size());
+    for (const Expression& arg : invoc.args) {
+        hash(md5, arg);
+    }
+}
+
+static void hash(llvm::MD5& md5, const TypeCast& cast) {
+    hash(md5, "cast");
+    hash(md5, cast.type);
+    hash(md5, *cast.expr);
+}
+
+static void hash(llvm::MD5& md5, const Expression& expr) {
+    std::visit([&md5](const auto& e) { hash(md5, e); }, expr.value);
+}
+
+static void hash(llvm::MD5& md5, const Declaration& decl) {
+    hash(md5, "declaration");
+    hash(md5, decl.variable);
+    hash(md5, decl.type);
+    hash(md5, size_t(decl.initializer.has_value()));
+    if (decl.initializer) {
+        hash(md5, *decl.initializer);
+    }
+    hash(md5, size_t(decl.noalias));
+    hash(md5, size_t(decl.constant));
+}
+
+static void hash(llvm::MD5& md5, const Import& import) {
+    hash(md5, "import");
+    hash(md5, llvm::StringRef(import.identifier));
+}
+
+static void hash(llvm::MD5& md5, const Conditional& cond) {
+    hash(md5, "conditional");
+    hash(md5, cond.condition);
+    hash(md5, cond.then_block);
+    hash(md5, cond.else_block);
+}
+
+static void hash(llvm::MD5& md5, const WhileLoop& loop) {
+    hash(md5, "while");
+    hash(md5, loop.condition);
+    hash(md5, loop.block);
+    hash(md5, size_t(loop.hints.vectorize_width));
+    hash(md5, size_t(loop.hints.unroll_count));
+    hash(md5, size_t(loop.hints.independent));
+}
+
+static void hash_signature(llvm::MD5& md5, const Procedure& proc) {
+    hash(md5, "procedure");
+    hash(md5, llvm::StringRef(proc.name));
+    hash(md5, proc.parameters.size());
+    for (const Declaration& param : proc.parameters) {
+        hash(md5, param);
+    }
+    hash(md5, proc.return_type);
+    hash(md5, size_t(proc.attributes));
+    hash(md5, proc.type_parameters.size());
+    for (const std::string& param : proc.type_parameters) {
+        hash(md5, llvm::StringRef(param));
+    }
+}
+
+static void hash(llvm::MD5& md5, const Procedure& proc) {
+    hash_signature(md5, proc);
+    hash(md5, proc.block);
+}
+
+static void hash(llvm::MD5& md5, const Return& ret) {
+    hash(md5, "return");
+    hash(md5, size_t(ret.value.has_value()));
+    if (ret.value) {
+        hash(md5, *ret.value);
+    }
+}
+
+static void hash(llvm::MD5& md5, const Typedef& def) {
+    hash(md5, "typedef");
+    hash(md5, llvm::StringRef(def.name));
+    hash(md5, def.type);
+}
+
+static void hash(llvm::MD5& md5, const Block& block) {
+    hash(md5, "block");
+    hash(md5, block.statements.size());
+    for (const Statement& stmt : block.statements) {
+        std::visit([&md5](const auto& s) { hash(md5, s); }, stmt.value);
+    }
+}
+
+// what every procedure of the program can see: all signatures (for overload
+// resolution and return types) and all named types (for layouts)
+static void hash_interface(llvm::MD5& md5) {
+    for (const auto& [name, procs] : procedure_definitions) {
+        for (const Procedure* proc : procs) {
+            hash_signature(md5, *proc);
+        }
+    }
+    for (const auto& [name, type] : type_definitions) {
+        hash(md5, llvm::StringRef(name));
+        hash(md5, *type);
+    }
+}
+
+static void hash_options(llvm::MD5& md5, unsigned opt_level, bool native) {
+    hash(md5, llvm::StringRef(cache_version));
+    hash(md5, llvm::StringRef(LLVM_VERSION_STRING));
+    hash(md5, llvm::StringRef(llvm::sys::getProcessTriple()));
+    hash(md5, opt_level);
+    hash(md5, size_t(native));
+    if (native) {
+        hash(md5, llvm::sys::getHostCPUName());
+    }
+}
+
+std::string procedure_key(const Procedure& proc, unsigned opt_level, bool native) {
+    llvm::MD5 md5;
+    hash_options(md5, opt_level, native);
+    hash_interface(md5);
+    hash(md5, proc);
+    llvm::MD5::MD5Result result;
+    md5.final(result);
+    return result.digest().str().str();
+}
+
+// storage
+// -------
+static std::string entry_path(const std::string& dir, const std::string& key) {
+    llvm::SmallString<256> path(dir);
+    llvm::sys::path::append(path, key + ".bc");
+    return path.str().str();
+}
+
+std::unique_ptr<llvm::Module> load_cached(const std::string& dir, const std::string& key,
+                                          llvm::LLVMContext& ctx) {
+    auto buffer = llvm::MemoryBuffer::getFile(entry_path(dir, key));
+    if (!buffer) {
+        return nullptr;
+    }
+    auto m = llvm::parseBitcodeFile((*buffer)->getMemBufferRef(), ctx);
+    if (!m) {
+        // a damaged entry is a miss, it is overwritten once recompiled
+        llvm::consumeError(m.takeError());
+        return nullptr;
+    }
+    return std::move(*m);
+}
+
+bool store_cached(const std::string& dir, const std::string& key, llvm::StringRef bitcode) {
+    if (std::error_code ec = llvm::sys::fs::create_directories(dir)) {
+        std::cerr << "could not create cache directory " << dir << ": " << ec.message() << std::endl;
+        return false;
+    }
+    // write next to the entry and rename, so readers never see half an entry
+    int fd;
+    llvm::SmallString<256> temp_path;
+    if (llvm::sys::fs::createUniqueFile(dir + "/" + key + "-%%%%%%.tmp", fd, temp_path)) {
+        std::cerr << "could not write to cache directory " << dir << std::endl;
+        return false;
+    }
+    {
+        llvm::raw_fd_ostream os(fd, /* shouldClose */ true);
+        os << bitcode;
+    }
+    if (llvm::sys::fs::rename(temp_path, entry_path(dir, key))) {
+        llvm::sys::fs::remove(temp_path);
+        std::cerr << "could not write to cache directory " << dir << std::endl;
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef PROCEDURE_CACHE_HPP
+#define PROCEDURE_CACHE_HPP
+
+#include <memory>
+#include <string>
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "parse_tree.hpp"
+
+// the optimized code of a procedure depends on its own parse tree, on the
+// signatures of the procedures it may call, on the types it may name and on
+// how it was compiled. the key hashes all of them (the signatures and types of
+// the whole program, so an edit to one procedure's body keeps every other key).
+// precondition: the program was type checked, so the definitions are filled in
+std::string procedure_key(const Procedure& proc, unsigned opt_level, bool native);
+
+// the cached module with this key, or nullptr if there is none (or it can't be read)
+std::unique_ptr<llvm::Module> load_cached(const std::string& dir, const std::string& key,
+                                          llvm::LLVMContext& ctx);
+
+// atomically replaces the cache entry, so concurrent compiles can share a cache
+bool store_cached(const std::string& dir, const std::string& key, llvm::StringRef bitcode);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,16 @@
 #!/bin/bash
 
-usage="usage: $0 src_filename [-o bin_filename]"
+# build driver: compiles src and every module it imports (transitively) to
+# bitcode and interfaces in the build directory, in parallel, then links the
+# bitcode into one program, optimizes it as a whole and generates code.
+# a module is only recompiled if its bitcode is older than its source or than
+# the interface of any module it imports. interfaces are only rewritten when
+# they change, so editing a procedure body does not recompile the importers.
+# with -t the modules are linked with ThinLTO instead: each module's bitcode
+# carries a summary, procedures are imported across modules where they are
+# called and the modules are optimized and compiled on -j threads
+
+usage="usage: $0 src_filename [-o bin_filename] [-O0|-O1|-O2|-O3] [-j jobs] [-I dir] [-B build_dir] [-t]"
 
 if [ -z "$1" ]
 then
@@ -8,19 +18,149 @@ then
     exit 1
 fi
 
-output=""
+src="$1"
+shift
 
-if [ ! -z "$2" ]
-then
-    if [[ "$2" != "-o" ]]; then
-        echo $usage
-        exit 1
-    elif [[ -z "$3" ]]; then
-        echo $usage
-        exit 1
+output="a.out"
+opt_level="-O0"
+jobs=$(nproc 2> /dev/null || echo 1)
+includes=()
+build_dir="rhythm_build"
+rhythmc="${RHYTHMC:-./rhythmc}"
+thin_lto=()
+
+while getopts "o:O:j:I:B:t" opt; do
+    case $opt in
+        o) output="$OPTARG" ;;
+        O) opt_level="-O$OPTARG" ;;
+        j) jobs="$OPTARG" ;;
+        I) includes+=(-I "$OPTARG") ;;
+        B) build_dir="$OPTARG" ;;
+        t) thin_lto=(--thin-lto) ;;
+        *) echo $usage
+           exit 1 ;;
+    esac
+done
+
+# imported module files, one per line. read from the sources, since the
+# interfaces of stale modules are only brought up to date below
+imports() {
+    "$rhythmc" "${includes[@]}" --deps "$1"
+}
+
+# where a module's outputs go below the build directory: its path relative
+# to the current directory without .rh, each leading .. (e.g. a module found
+# through -I ../lib) replaced by __ so nothing is written outside of it.
+# rhythmc looks interfaces up the same way (see imports.cpp)
+build_path() {
+    local path=$(realpath --relative-to=. "$1")
+    local prefix=""
+    while [[ $path == ../* ]]; do
+        prefix+="__/"
+        path=${path#../}
+    done
+    echo "$prefix${path%.rh}"
+}
+
+# ThinLTO bitcode is kept apart, so switching modes recompiles everything
+bitcode() {
+    if [ ${#thin_lto[@]} -eq 0 ]; then
+        echo "$build_dir/$(build_path "$1").bc"
+    else
+        echo "$build_dir/$(build_path "$1").thin.bc"
     fi
+}
 
-    output="-o $3"
-fi
+interface() {
+    echo "$build_dir/$(build_path "$1").rhi"
+}
+
+# the bitcode and interface are missing or older than the source, or an
+# imported module's interface changed after the bitcode was built
+stale() {
+    local bc=$(bitcode "$1")
+    [ ! -f "$bc" ] && return 0
+    [ ! -f "$(interface "$1")" ] && return 0
+    [ "$1" -nt "$bc" ] && return 0
+    local dep
+    for dep in ${deps[$1]}; do
+        [ "$(interface "$dep")" -nt "$bc" ] && return 0
+    done
+    return 1
+}
+
+modules=("$src")
+src_deps=$(imports "$src") || exit 1
+for dep in $src_deps; do
+    modules+=("$dep")
+done
+declare -A deps
+for module in "${modules[@]}"; do
+    deps[$module]=$(imports "$module") || exit 1
+done
+
+# compile in waves. a module waits for the stale modules it imports, so it
+# reads their new interfaces, and is only compiled if one of them changed.
+# rhythmc trusts every interface it finds in the build directory.
+# the modules of a wave are compiled at the same time. each module is
+# compiled at most once
+declare -A compiled
+while true; do
+    wave=()
+    blocked=()
+    interfaces=(--interface-dir "$build_dir")
+    for module in "${modules[@]}"; do
+        if [ -n "${compiled[$module]}" ] || ! stale "$module"; then
+            continue
+        fi
+        waiting=0
+        for dep in ${deps[$module]}; do
+            if [ -z "${compiled[$dep]}" ] && stale "$dep"; then
+                waiting=1
+            fi
+        done
+        if [ $waiting -eq 0 ]; then
+            wave+=("$module")
+        else
+            blocked+=("$module")
+        fi
+    done
+    # modules that import each other can't wait for each other, so they
+    # parse each other's sources instead of reading outdated interfaces
+    if [ ${#wave[@]} -eq 0 ]; then
+        wave=("${blocked[@]}")
+        interfaces=()
+    fi
+    if [ ${#wave[@]} -eq 0 ]; then
+        break
+    fi
+
+    running=0
+    failed=0
+    for module in "${wave[@]}"; do
+        compiled[$module]=1
+        bc=$(bitcode "$module")
+        mkdir -p "$(dirname "$bc")"
+        echo "compiling $module"
+        "$rhythmc" $opt_level "${includes[@]}" "${interfaces[@]}" \
+            --emit-interface "$(interface "$module")" "${thin_lto[@]}" --bitcode -o "$bc" "$module" &
+        running=$((running + 1))
+        if [ $running -ge $jobs ]; then
+            wait -n || failed=1
+            running=$((running - 1))
+        fi
+    done
+    while [ $running -gt 0 ]; do
+        wait -n || failed=1
+        running=$((running - 1))
+    done
+    if [ $failed -ne 0 ]; then
+        exit 1
+    fi
+done
 
-./rhythmc < $1 | clang -x ir - -Wno-override-module $output
+units=()
+for module in "${modules[@]}"; do
+    units+=("$(bitcode "$module")")
+done
+"$rhythmc" $opt_level "${thin_lto[@]}" -j "$jobs" -o "$output" "${units[@]}"
@@ -0,0 +1,218 @@
+#include "statistics.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sys/resource.h>
+#include "arena.hpp"
+#include "symbol_table.hpp"
+#include "type_system.hpp"
+
+extern int line_num;
+
+Statistics statistics;
+
+void Statistics::add_time(const std::string& phase, double seconds) {
+    auto it = std::find_if(phases.begin(), phases.end(),
+        [&phase](auto& p) { return p.first == phase; });
+    if (it == phases.end()) {
+        phases.emplace_back(phase, seconds);
+    }
+    else {
+        it->second += seconds;
+    }
+}
+
+PhaseTimer::~PhaseTimer() {
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    statistics.add_time(phase, elapsed.count());
+}
+
+// parse tree
+// ----------
+static void count(const Expression& expr);
+static void count(const Block& block);
+
+static void count(const Literal&) {}
+static void count(const Variable&) {}
+
+static void count(const Invocation& invoc) {
+    for (const Expression& arg : invoc.args) {
+        count(arg);
+    }
+}
+
+static void count(const TypeCast& cast) {
+    count(*cast.expr);
+}
+
+static void count(const Expression& expr) {
+    ++statistics.expressions;
+    std::visit([](auto& x) { count(x); }, expr.value);
+}
+
+static void count(const Declaration& decl) {
+    if (decl.initializer) {
+        count(*decl.initializer);
+    }
+}
+
+static void count(const Import&) {}
+static void count(const Typedef&) {}
+
+static void count(const Conditional& cond) {
+    count(cond.condition);
+    count(cond.then_block);
+    count(cond.else_block);
+}
+
+static void count(const WhileLoop& loop) {
+    count(loop.condition);
+    count(loop.block);
+}
+
+static void count(const Procedure& proc) {
+    count(proc.block);
+}
+
+static void count(const Return& ret) {
+    if (ret.value) {
+        count(*ret.value);
+    }
+}
+
+static void count(const Block& block) {
+    for (const Statement& stmt : block.statements) {
+        ++statistics.statements;
+        std::visit([](auto& x) { count(x); }, stmt.value);
+    }
+}
+
+void count_nodes(const Block& program) {
+    count(program);
+}
+
+// ir
+// --
+void count_instructions(const llvm::Module& m, bool optimized) {
+    count_instructions(m, optimized, statistics.procedures);
+}
+
+void count_instructions(const llvm::Module& m, bool optimized, std::vector<Statistics::Procedure>& procs) {
+    for (const llvm::Function& f : m) {
+        if (f.isDeclaration()) {
+            continue;
+        }
+        std::string name = f.getName().str();
+        auto it = std::find_if(procs.begin(), procs.end(),
+            [&name](auto& p) { return p.name == name; });
+        if (it == procs.end()) {
+            procs.push_back({name, 0, 0});
+            it = procs.end() - 1;
+        }
+        (optimized ? it->optimized_instructions : it->emitted_instructions) = f.getInstructionCount();
+    }
+}
+
+// reports
+// -------
+static size_t peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static std::vector<std::pair<const char*, size_t>> counters() {
+    return {
+        { "source_lines",    size_t(line_num) },
+        { "tokens",          statistics.tokens },
+        { "statements",      statistics.statements },
+        { "expressions",     statistics.expressions },
+        { "arena_bytes",     parse_arena.allocated() },
+        { "arena_objects",   parse_arena.objects() },
+        { "interned_types",  TypeSystem::interned_count() },
+        { "symbol_lookups",  symbol_lookups },
+        { "cache_hits",      statistics.cache_hits },
+        { "cache_misses",    statistics.cache_misses },
+        { "peak_rss_kb",     peak_rss_kb() },
+    };
+}
+
+static std::string json_string(const std::string& s) {
+    std::string quoted = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static void print_json(std::ostream& os, bool time_passes, bool stats) {
+    const char* separator = "";
+    os << "{";
+    if (time_passes) {
+        os << "\"phases\": {";
+        for (auto& [phase, seconds] : statistics.phases) {
+            os << separator << json_string(phase) << ": " << seconds;
+            separator = ", ";
+        }
+        os << "}";
+        separator = ", ";
+    }
+    if (stats) {
+        os << separator << "\"counters\": {";
+        separator = "";
+        for (auto& [name, value] : counters()) {
+            os << separator << json_string(name) << ": " << value;
+            separator = ", ";
+        }
+        os << "}, \"procedures\": [";
+        separator = "";
+        for (auto& proc : statistics.procedures) {
+            os << separator << "{\"name\": " << json_string(proc.name)
+               << ", \"emitted_instructions\": " << proc.emitted_instructions
+               << ", \"optimized_instructions\": " << proc.optimized_instructions << "}";
+            separator = ", ";
+        }
+        os << "]";
+    }
+    os << "}" << std::endl;
+}
+
+static void print_text(std::ostream& os, bool time_passes, bool stats) {
+    if (time_passes) {
+        double total = 0;
+        for (auto& phase : statistics.phases) {
+            total += phase.second;
+        }
+        os << "===--- phase timing ---===" << std::endl << std::fixed;
+        for (auto& [phase, seconds] : statistics.phases) {
+            os << "  " << std::left << std::setw(16) << phase << std::right
+               << std::setprecision(3) << std::setw(10) << seconds * 1000 << " ms"
+               << std::setprecision(1) << std::setw(7) << (total > 0 ? 100 * seconds / total : 0) << "%" << std::endl;
+        }
+        os << "  " << std::left << std::setw(16) << "total" << std::right
+           << std::setprecision(3) << std::setw(10) << total * 1000 << " ms" << std::endl;
+        os << std::defaultfloat;
+    }
+    if (stats) {
+        os << "===--- statistics ---===" << std::endl;
+        for (auto& [name, value] : counters()) {
+            os << "  " << std::left << std::setw(16) << name << std::right << std::setw(12) << value << std::endl;
+        }
+        os << "  instructions per procedure (emitted -> optimized)" << std::endl;
+        for (auto& proc : statistics.procedures) {
+            os << "  " << std::setw(8) << proc.emitted_instructions << " -> " << std::left
+               << std::setw(8) << proc.optimized_instructions << std::right << proc.name << std::endl;
+        }
+    }
+}
+
+void print_statistics(std::ostream& os, bool time_passes, bool stats, bool json) {
+    if (json) {
+        print_json(os, time_passes, stats);
+    }
+    else {
+        print_text(os, time_passes, stats);
+    }
+}
\ No newline at end of file
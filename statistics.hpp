@@ -0,0 +1,60 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "llvm/IR/Module.h"
+#include "parse_tree.hpp"
+
+// compile time measurements, reported by --time-passes and --stats
+struct Statistics {
+    // time the lexer. it is timed per token, so only when asked for
+    bool time_lexer = false;
+
+    // wall time in seconds per phase, in the order the phases first ran
+    std::vector<std::pair<std::string, double>> phases;
+
+    size_t tokens = 0;
+    size_t statements = 0;
+    size_t expressions = 0;
+    // procedures reused from and added to the --cache
+    size_t cache_hits = 0;
+    size_t cache_misses = 0;
+
+    struct Procedure {
+        std::string name;
+        size_t emitted_instructions;
+        size_t optimized_instructions;
+    };
+    std::vector<Procedure> procedures;
+
+    void add_time(const std::string& phase, double seconds);
+};
+
+extern Statistics statistics;
+
+// adds the wall time spent in its scope to a phase
+struct PhaseTimer {
+    explicit PhaseTimer(std::string phase)
+        : phase(std::move(phase)), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer();
+private:
+    std::string phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+// count the statements and expressions in the parse tree
+void count_nodes(const Block& program);
+
+// record the instruction count of every defined procedure, as emitted or after optimization
+void count_instructions(const llvm::Module& m, bool optimized);
+void count_instructions(const llvm::Module& m, bool optimized, std::vector<Statistics::Procedure>& procs);
+
+// human readable text, or a single json object
+void print_statistics(std::ostream& os, bool time_passes, bool stats, bool json);
+
+#endif
\ No newline at end of file
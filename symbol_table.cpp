@@ -0,0 +1,11 @@
+#include "symbol_table.hpp"
+
+#include <unordered_map>
+
+thread_local size_t symbol_lookups = 0;
+
+static std::unordered_map<std::string, Identifier> identifier_ids;
+
+Identifier intern_identifier(const std::string& name) {
+    return identifier_ids.try_emplace(name, Identifier(identifier_ids.size())).first->second;
+}
\ No newline at end of file
@@ -1,58 +1,88 @@
 #ifndef SYMBOL_TABLE_HPP
 #define SYMBOL_TABLE_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include "llvm/IR/Instructions.h"
+
+// identifiers are interned once (by the parser) to dense ids, so scope
+// lookups index a vector instead of hashing the name in every frame
+using Identifier = uint32_t;
+
+Identifier intern_identifier(const std::string& name);
+
+// number of SymbolTable::find calls on this thread, for --stats
+extern thread_local size_t symbol_lookups;
 
 template<typename Domain, typename Range>
-// Domain must have a std::string field `name`
+// Domain must have an Identifier field `id`
+// every identifier has a stack of bindings, innermost last, and each frame
+// records which identifiers it bound so pop_frame can unbind exactly those.
+// add, find and find_current_frame are O(1) regardless of nesting depth
 struct SymbolTable {
     void push_frame() {
-        table.emplace_back();
+        frames.push_back(bound.size());
     }
 
     void pop_frame() {
-        table.pop_back();
+        for (size_t first = frames.back(); bound.size() > first; bound.pop_back()) {
+            bindings[bound.back()].pop_back();
+        }
+        frames.pop_back();
     }
 
     void add(const Domain& symbol, Range* value) {
-        add(symbol.name, value);
+        add(symbol.id, value);
     }
 
-    void add(const std::string& name, Range* value) {
-        table.back()[name] = value;
+    void add(Identifier id, Range* value) {
+        if (id >= bindings.size()) {
+            bindings.resize(id + 1);
+        }
+        auto& stack = bindings[id];
+        if (!stack.empty() && stack.back().depth == frames.size()) {
+            // redefinition in the same frame replaces the binding
+            stack.back().value = value;
+            return;
+        }
+        stack.push_back({frames.size(), value});
+        bound.push_back(id);
     }
 
-    Range* find_current_frame(const Domain& symbol) {
-        return find_current_frame(symbol.name);
+    Range* find_current_frame(const Domain& symbol) const {
+        return find_current_frame(symbol.id);
     }
-    Range* find(const Domain& symbol) {
-        return find(symbol.name);
+    Range* find(const Domain& symbol) const {
+        return find(symbol.id);
     }
 
-    Range* find_current_frame(const std::string& name) {
-        if (auto it = table.back().find(name); it != table.back().end()) {
-            return it->second;
+    Range* find_current_frame(Identifier id) const {
+        if (id < bindings.size() && !bindings[id].empty() &&
+            bindings[id].back().depth == frames.size()) {
+            return bindings[id].back().value;
         }
         return nullptr;
     }
 
-    Range* find(const std::string& name) {
-        auto map_it = std::find_if(table.rbegin(), table.rend(),
-            [name](auto& map) {
-                return map.find(name) != map.end();
-            });
-
-        if (map_it != table.rend()) {
-            return map_it->find(name)->second;
+    Range* find(Identifier id) const {
+        ++symbol_lookups;
+        if (id < bindings.size() && !bindings[id].empty()) {
+            return bindings[id].back().value;
         }
-
         return nullptr;
     }
 private:
-    std::vector<std::unordered_map<std::string, Range*>> table;
+    struct Binding {
+        size_t depth;
+        Range* value;
+    };
+    // indexed by identifier
+    std::vector<std::vector<Binding>> bindings;
+    // identifiers bound, in order, across all open frames
+    std::vector<Identifier> bound;
+    // size of `bound` when each frame was pushed
+    std::vector<size_t> frames;
 };
 
 
@@ -0,0 +1,58 @@
+#include "target.hpp"
+#include <iostream>
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetOptions.h"
+
+llvm::CodeGenOpt::Level codegen_level(unsigned opt_level) {
+    switch (opt_level) {
+    case 0:  return llvm::CodeGenOpt::None;
+    case 1:  return llvm::CodeGenOpt::Less;
+    case 2:  return llvm::CodeGenOpt::Default;
+    default: return llvm::CodeGenOpt::Aggressive;
+    }
+}
+
+std::string host_features() {
+    llvm::StringMap<bool> features;
+    if (!llvm::sys::getHostCPUFeatures(features)) {
+        return "";
+    }
+
+    std::string result;
+    for (const auto& feature : features) {
+        if (!result.empty()) {
+            result += ",";
+        }
+        result += (feature.second ? "+" : "-") + feature.first().str();
+    }
+    return result;
+}
+
+std::unique_ptr<llvm::TargetMachine> host_target_machine(unsigned opt_level, bool native) {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    std::string triple = llvm::sys::getDefaultTargetTriple();
+    std::string err;
+    const llvm::Target* target = llvm::TargetRegistry::lookupTarget(triple, err);
+    if (!target) {
+        std::cerr << "could not find target " << triple << ": " << err << std::endl;
+        return nullptr;
+    }
+
+    std::string cpu = native ? llvm::sys::getHostCPUName().str() : "generic";
+    std::string features = native ? host_features() : "";
+
+    llvm::TargetOptions options;
+    return std::unique_ptr<llvm::TargetMachine>(
+        target->createTargetMachine(triple, cpu, features, options,
+                                    llvm::Reloc::PIC_, llvm::None, codegen_level(opt_level)));
+}
+
+void set_target(llvm::Module& m, const llvm::TargetMachine& tm) {
+    m.setTargetTriple(tm.getTargetTriple().str());
+    m.setDataLayout(tm.createDataLayout());
+}
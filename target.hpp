@@ -0,0 +1,23 @@
+#ifndef TARGET_HPP
+#define TARGET_HPP
+
+#include <memory>
+#include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
+
+// create a target machine for the host triple. with native set, code is tuned
+// for and may use every feature of the host cpu (-march=native), otherwise it
+// targets a generic cpu. returns nullptr (and prints why) if the host target
+// is not registered
+std::unique_ptr<llvm::TargetMachine> host_target_machine(unsigned opt_level, bool native = false);
+
+llvm::CodeGenOpt::Level codegen_level(unsigned opt_level);
+
+// features of the host cpu in target feature string form (e.g. "+avx2,-avx512f")
+std::string host_features();
+
+// stamp the module with the machine's triple and data layout so that the
+// optimizer can query target costs (e.g. for vectorization)
+void set_target(llvm::Module& m, const llvm::TargetMachine& tm);
+
+#endif
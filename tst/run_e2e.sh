@@ -1,6 +1,7 @@
 #!/bin/bash
 
-find tst/e2e -type f -name "*.rh" | while read fname; do
+# modules the tests import live in tst/e2e/modules and are not tests themselves
+find tst/e2e -maxdepth 1 -type f -name "*.rh" | while read fname; do
     # get files
     test_fname="${fname%.*}"
     echo "$test_fname"
@@ -8,7 +9,7 @@ find tst/e2e -type f -name "*.rh" | while read fname; do
     test_output_fname="${test_fname}.out"
 
     # run test
-    ./rhythmc.sh $fname -o $test_fname
+    ./rhythmc.sh $fname -o $test_fname -I tst/e2e/modules
     if [ -f $test_input_fname ]; then
         test_actual_output=$($test_fname < $test_input_fname)
     else
@@ -21,3 +22,10 @@ find tst/e2e -type f -name "*.rh" | while read fname; do
     # cleanup executable
     rm $test_fname
 done
+
+# programs that must not compile, and the errors rhythmc reports for them
+find tst/e2e/errors -maxdepth 1 -type f -name "*.rh" | while read fname; do
+    test_fname="${fname%.*}"
+    echo "$test_fname"
+    diff "${test_fname}.err" <(./rhythmc $fname 2>&1 >/dev/null)
+done
@@ -0,0 +1,364 @@
+#include "type_checker.hpp"
+#include <iostream>
+#include <set>
+#include "constant_eval.hpp"
+#include "generics.hpp"
+#include "overloads.hpp"
+#include "symbol_table.hpp"
+#include "type_system.hpp"
+
+// declarations visible at the current point of the walk
+static SymbolTable<Variable, const Declaration> declaration_table;
+// procedures being checked around the current point. declarations outside of
+// any are globals
+static size_t procedure_depth = 0;
+
+// expressions
+// -----------
+static bool check_children(Literal&) {
+    return true;
+}
+
+static bool check_children(Variable& var) {
+    // unresolved variables are reported by type_of
+    var.declaration = declaration_table.find(var);
+    return true;
+}
+
+static bool check_children(Invocation& invoc) {
+    // the right hand side of field access is a field name, not a variable
+    if (invoc.name == "." && !invoc.args.empty()) {
+        return check_expr(invoc.args.front());
+    }
+
+    bool success = true;
+    for (Expression& arg : invoc.args) {
+        success = check_expr(arg) && success;
+    }
+    if (invoc.name == "<-" && success) {
+        auto var = std::get_if<Variable>(&invoc.args.front().value);
+        if (var && var->declaration && var->declaration->constant) {
+            std::cerr << "can't assign to `" << var->name << "`, it is declared with let" << std::endl;
+            return false;
+        }
+    }
+    return success;
+}
+
+static bool check_children(TypeCast& cast) {
+    return check_expr(*cast.expr);
+}
+
+// calls of constexpr procedures whose arguments are constants become literals
+// of the call's type. calls that can't be evaluated are left to run
+static void fold_constant(Expression& expr) {
+    auto invoc = std::get_if<Invocation>(&expr.value);
+    if (!invoc) {
+        return;
+    }
+    if (TypeSystem::is_intrinsic_op(*invoc)) {
+        return;
+    }
+    std::vector<TypeSystem::TypeRef> arg_types;
+    for (const Expression& arg : invoc->args) {
+        arg_types.push_back(arg.type);
+    }
+    // built-in procedures (e.g. deref) are not in the index and resolve to nullptr
+    const Procedure* proc = resolve_overload(invoc->name, arg_types);
+    if (!proc || !(proc->attributes & Procedure::constant)) {
+        return;
+    }
+    if (std::optional<Constant> c = evaluate(expr); c && c->type == expr.type) {
+        bool integer = !TypeSystem::is_floating_point(c->type);
+        expr.value = Literal{to_literal(*c), integer ? Literal::Type::integer : Literal::Type::rational};
+    }
+}
+
+bool check_expr(Expression& expr) {
+    if (expr.type) {
+        return true;
+    }
+
+    bool success = std::visit([](auto& x) { return check_children(x); }, expr.value);
+
+    // children are annotated, so this only resolves the node itself
+    size_t errors = TypeSystem::error_count();
+    expr.type = TypeSystem::type_of(expr);
+    success = success && errors == TypeSystem::error_count();
+    if (success) {
+        fold_constant(expr);
+    }
+    return success;
+}
+
+// statements
+// ----------
+bool check_stmt(Expression& expr) {
+    return check_expr(expr);
+}
+
+// blocks whose procedures and typedefs are registered
+static std::set<const Block*> declared_blocks;
+
+// procedures and typedefs may be used before (above) their definition, and
+// those of imported modules (transitively) anywhere in the importing block
+static void declare_stmts(const Block& block, bool imported = false) {
+    if (!declared_blocks.insert(&block).second) {
+        return;
+    }
+    for (const Statement& stmt : block.statements) {
+        if (auto proc = std::get_if<Procedure>(&stmt.value)) {
+            // other modules only see what they export
+            if (!imported || (proc->attributes & Procedure::exported)) {
+                procedure_definitions[proc->name].push_back(proc);
+            }
+        }
+        else if (auto def = std::get_if<Typedef>(&stmt.value)) {
+            type_definitions[def->name] = &def->type;
+        }
+        else if (auto import = std::get_if<Import>(&stmt.value); import && import->module) {
+            declare_stmts(*import->module, true);
+        }
+    }
+}
+
+static bool check_stmt_current_frame(Block& block) {
+    declare_stmts(block);
+
+    bool success = true;
+    for (Statement& stmt : block.statements) {
+        success = check_stmt(stmt) && success;
+    }
+    return success;
+}
+
+bool check_stmt(Block& block) {
+    declaration_table.push_frame();
+    bool success = check_stmt_current_frame(block);
+    declaration_table.pop_frame();
+    return success;
+}
+
+// constant sizes
+// --------------
+// size expressions (e.g. `Array(Int, (4 * n()))`) are replaced by their
+// values once the program is checked, so the phases after checking (module
+// interfaces, the procedure cache, the emitters) only see literal sizes
+struct SizeFolder {
+    bool success = true;
+    std::set<const Block*> folded;
+
+    void fold(Type& t) {
+        for (auto& param : t.parameters) {
+            if (auto p = std::get_if<Type>(&param)) {
+                fold(*p);
+            }
+            else if (auto decl = std::get_if<Declaration>(&param)) {
+                fold(decl->type);
+            }
+            else if (auto expr = std::get_if<Expression*>(&param)) {
+                std::string why;
+                if (std::optional<size_t> size = constant_size(**expr, &why)) {
+                    param = *size;
+                }
+                else {
+                    std::cerr << "size is not a constant: " << why << std::endl;
+                    success = false;
+                }
+            }
+        }
+    }
+
+    void fold(Expression& expr) {
+        std::visit([this](auto& x) { fold(x); }, expr.value);
+    }
+    void fold(Literal&) {}
+    void fold(Variable&) {}
+    void fold(Invocation& invoc) {
+        for (Expression& arg : invoc.args) {
+            fold(arg);
+        }
+    }
+    void fold(TypeCast& cast) {
+        fold(cast.type);
+        fold(*cast.expr);
+    }
+
+    void fold(Statement& stmt) {
+        std::visit([this](auto& x) { fold(x); }, stmt.value);
+    }
+    void fold(Block& block) {
+        if (!folded.insert(&block).second) {
+            return;
+        }
+        for (Statement& stmt : block.statements) {
+            fold(stmt);
+        }
+    }
+    void fold(Declaration& decl) {
+        fold(decl.type);
+        if (decl.initializer) {
+            fold(*decl.initializer);
+        }
+    }
+    // imported modules are in the parse arena like the program, only the
+    // links to them are const. their signatures are hashed by the cache
+    void fold(Import& import) {
+        if (import.module) {
+            fold(const_cast<Block&>(*import.module));
+        }
+    }
+    void fold(Conditional& cond) {
+        fold(cond.condition);
+        fold(cond.then_block);
+        fold(cond.else_block);
+    }
+    void fold(WhileLoop& loop) {
+        fold(loop.condition);
+        fold(loop.block);
+    }
+    void fold(Procedure& proc) {
+        for (Declaration& param : proc.parameters) {
+            fold(param);
+        }
+        fold(proc.return_type);
+        fold(proc.block);
+    }
+    void fold(Return& ret) {
+        if (ret.value) {
+            fold(*ret.value);
+        }
+    }
+    void fold(Typedef& def) {
+        fold(def.type);
+    }
+};
+
+bool check_program(Block& program) {
+    declaration_table.push_frame();
+    bool success = check_stmt_current_frame(program);
+    // checking an instance can make more (e.g. generic procedures calling each other)
+    for (size_t i = 0; i < procedure_instances.size(); ++i) {
+        success = check_stmt(*procedure_instances[i]) && success;
+    }
+    declaration_table.pop_frame();
+    if (!success) {
+        return false;
+    }
+
+    SizeFolder folder;
+    folder.fold(program);
+    for (Procedure* instance : procedure_instances) {
+        folder.fold(*instance);
+    }
+    return folder.success;
+}
+
+// whether a value of type `from` initializes a variable of type `to`. the same
+// for every declaration, whether its value is stored when the declaration runs
+// or computed here as constant data: integers convert to integers of any width
+// (wrapping), and floating point numbers are rounded to the variable's precision
+static bool initializes(TypeSystem::TypeRef from, TypeSystem::TypeRef to) {
+    return from == to
+        || (TypeSystem::is_integral(from) && TypeSystem::is_integral(to))
+        || (TypeSystem::is_floating_point(from) && TypeSystem::is_floating_point(to));
+}
+
+bool check_stmt(Declaration& decl) {
+    decl.global = procedure_depth == 0;
+    if (decl.constant && !decl.initializer) {
+        std::cerr << "`" << decl.variable.name << "` is declared with let, but not initialized" << std::endl;
+        return false;
+    }
+    bool success = !decl.initializer || check_expr(*decl.initializer);
+    // e.g. an unknown type or a size that is not a constant
+    size_t errors = TypeSystem::error_count();
+    TypeSystem::TypeRef type = TypeSystem::intern(decl.type);
+    success = success && errors == TypeSystem::error_count();
+    if (success && decl.initializer) {
+        auto literal = std::get_if<Invocation>(&decl.initializer->value);
+        bool array_literal = literal && literal->name == "[]";
+        std::string why;
+        if (array_literal && !decl.global && !decl.constant) {
+            std::cerr << "array literals only initialize globals and let variables, not `"
+                      << decl.variable.name << "`" << std::endl;
+            success = false;
+        }
+        // array literals convert element by element, see evaluate_initializer
+        else if (!array_literal && !initializes(decl.initializer->type, type)) {
+            std::cerr << "`" << decl.variable.name << "` is a `" << type->mangled << "` and can't be initialized with a `"
+                      << decl.initializer->type->mangled << "`" << std::endl;
+            success = false;
+        }
+        // globals and let variables are emitted with their data, which is computed here
+        else if ((decl.global || decl.constant) && !evaluate_initializer(*decl.initializer, type, &why)) {
+            std::cerr << "initializer of `" << decl.variable.name << "` is not constant data: " << why << std::endl;
+            success = false;
+        }
+    }
+    declaration_table.add(decl.variable, &decl);
+    return success;
+}
+
+bool check_stmt(Import& import) {
+    // the module's own procedures are checked when it is compiled
+    if (!import.module) {
+        std::cerr << "unresolved import " << import.identifier << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool check_stmt(Conditional& cond) {
+    bool success = check_expr(cond.condition);
+    success = check_stmt(cond.then_block) && success;
+    return check_stmt(cond.else_block) && success;
+}
+
+bool check_stmt(WhileLoop& loop) {
+    bool success = check_expr(loop.condition);
+    return check_stmt(loop.block) && success;
+}
+
+bool check_stmt(Procedure& proc) {
+    if ((proc.attributes & Procedure::always_inline) && (proc.attributes & Procedure::never_inline)) {
+        std::cerr << "procedure " << proc.name << " can't be both inline and noinline" << std::endl;
+        return false;
+    }
+    // only its instances are checked, once the type parameters are known
+    if (!proc.type_parameters.empty()) {
+        return true;
+    }
+    for (const Declaration& param : proc.parameters) {
+        if (param.noalias && !TypeSystem::is_pointer(TypeSystem::intern(param.type))) {
+            std::cerr << "parameter " << param.variable.name << " of " << proc.name
+                      << " is noalias but not a Pointer" << std::endl;
+            return false;
+        }
+    }
+    // parameters share the body's frame
+    declaration_table.push_frame();
+    for (const Declaration& param : proc.parameters) {
+        declaration_table.add(param.variable, &param);
+    }
+    ++procedure_depth;
+    bool success = check_stmt_current_frame(proc.block);
+    --procedure_depth;
+    declaration_table.pop_frame();
+    return success;
+}
+
+bool check_stmt(Return& ret) {
+    if (ret.value) {
+        return check_expr(*ret.value);
+    }
+    return true;
+}
+
+bool check_stmt(Typedef&) {
+    return true;
+}
+
+bool check_stmt(Statement& stmt) {
+    return std::visit([](auto& x) { return check_stmt(x); }, stmt.value);
+}
@@ -0,0 +1,28 @@
+#ifndef TYPE_CHECKER_HPP
+#define TYPE_CHECKER_HPP
+
+#include "parse_tree.hpp"
+
+// annotate every expression in the tree with its type (Expression::type).
+// each node is resolved exactly once, bottom up, so that later calls to
+// TypeSystem::type_of (emission, overload resolution, name decoration) are
+// lookups instead of recursive re-evaluations.
+// returns false if any type error was reported
+bool check_expr(Expression  & expr );
+
+bool check_stmt(Expression  & expr );
+bool check_stmt(Block       & block);
+bool check_stmt(Declaration & decl );
+bool check_stmt(Import      & import);
+bool check_stmt(Conditional & cond );
+bool check_stmt(WhileLoop   & loop );
+bool check_stmt(Procedure   & proc );
+bool check_stmt(Return      & ret  );
+bool check_stmt(Typedef     & def  );
+bool check_stmt(Statement   & stmt );
+
+// check the program, then the instances of generic procedures its calls need
+// (see generics.hpp)
+bool check_program(Block& program);
+
+#endif
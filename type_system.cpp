@@ -1,72 +1,454 @@
 #include "type_system.hpp"
+#include "constant_eval.hpp"
+#include "overloads.hpp"
 #include <iostream>
 #include <cassert>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <optional>
+#include <unordered_map>
 
 constexpr size_t pointer_size = sizeof(int*);
 
 namespace TypeSystem {
 
+static std::atomic<size_t> errors = 0;
+
+static TypeRef error(const std::string& str) {
+    ++errors;
+    std::cerr << str << std::endl;
+    return Intrinsics::void0;
+}
+
+template<typename First, typename ... T>
+bool is_in(First&& first, T&& ... t)
+{
+    return ((first == t) || ...);
+}
+
+size_t error_count() {
+    return errors;
+}
+
 namespace Intrinsics {
-const Type void0    = Type{"Void"};
 
-const Type boolean  = Type{"Bool"};
+static TypeInfo scalar(const std::string& name, unsigned flags, size_t size) {
+    TypeInfo info;
+    info.name = name;
+    info.flags = flags;
+    info.size = size;
+    info.mangled = name;
+    return info;
+}
+
+// the intrinsic types are never looked up in the intern table, so their
+// handles are the addresses of these statics (and usable during static init)
+static const TypeInfo void0_info   = scalar("Void",  TypeInfo::void0, 0);
+
+static const TypeInfo boolean_info = scalar("Bool",  TypeInfo::boolean, 1);
+
+static const TypeInfo integer_info = scalar("Int",   TypeInfo::signed_integral, 4);
+static const TypeInfo int8_info    = scalar("Int8",  TypeInfo::signed_integral, 1);
+static const TypeInfo int16_info   = scalar("Int16", TypeInfo::signed_integral, 2);
+static const TypeInfo int32_info   = scalar("Int32", TypeInfo::signed_integral, 4);
+static const TypeInfo int64_info   = scalar("Int64", TypeInfo::signed_integral, 8);
 
-const Type integer  = Type{"Int"};
-const Type int8     = Type{"Int8"};
-const Type int16    = Type{"Int16"};
-const Type int32    = Type{"Int32"};
-const Type int64    = Type{"Int64"};
+static const TypeInfo natural_info = scalar("Nat",   TypeInfo::unsigned_integral, 4);
+static const TypeInfo nat8_info    = scalar("Nat8",  TypeInfo::unsigned_integral, 1);
+static const TypeInfo nat16_info   = scalar("Nat16", TypeInfo::unsigned_integral, 2);
+static const TypeInfo nat32_info   = scalar("Nat32", TypeInfo::unsigned_integral, 4);
+static const TypeInfo nat64_info   = scalar("Nat64", TypeInfo::unsigned_integral, 8);
 
-const Type natural  = Type{"Nat"};
-const Type nat8     = Type{"Nat8"};
-const Type nat16    = Type{"Nat16"};
-const Type nat32    = Type{"Nat32"};
-const Type nat64    = Type{"Nat64"};
+static const TypeInfo float32_info = scalar("Flt32", TypeInfo::floating_point, 4);
+static const TypeInfo float64_info = scalar("Flt64", TypeInfo::floating_point, 8);
 
-const Type float32  = Type{"Flt32"};
-const Type float64  = Type{"Flt64"};
+const TypeRef void0    = &void0_info;
+
+const TypeRef boolean  = &boolean_info;
+
+const TypeRef integer  = &integer_info;
+const TypeRef int8     = &int8_info;
+const TypeRef int16    = &int16_info;
+const TypeRef int32    = &int32_info;
+const TypeRef int64    = &int64_info;
+
+const TypeRef natural  = &natural_info;
+const TypeRef nat8     = &nat8_info;
+const TypeRef nat16    = &nat16_info;
+const TypeRef nat32    = &nat32_info;
+const TypeRef nat64    = &nat64_info;
+
+const TypeRef float32  = &float32_info;
+const TypeRef float64  = &float64_info;
 
 // names of type constructors
 const std::string pointer = "Pointer";
 const std::string array = "Array";
+const std::string vector = "Vector";
 const std::string structure = "Struct";
 
-Type make_pointer(const Type& value_type) {
-    return Type{pointer, {value_type}};
 }
 
-Type make_array(const Type& value_type, size_t sz) {
-    return Type{array, {value_type, sz}};
+// intern table
+// ------------
+// structural identity of a constructed (non-intrinsic) type. typedef'd types
+// are identified by name alone
+struct TypeKey {
+    std::string name;
+    TypeRef value_type = nullptr;
+    size_t num_elements = 0;
+    std::vector<std::pair<std::string, TypeRef>> fields;
+};
+
+static bool operator==(const TypeKey& lhs, const TypeKey& rhs) {
+    return lhs.name == rhs.name &&
+           lhs.value_type == rhs.value_type &&
+           lhs.num_elements == rhs.num_elements &&
+           lhs.fields == rhs.fields;
+}
+
+struct TypeKeyHash {
+    size_t operator()(const TypeKey& key) const {
+        size_t h = std::hash<std::string>{}(key.name);
+        auto combine = [&h](size_t v) { h ^= v + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2); };
+        combine(std::hash<TypeRef>{}(key.value_type));
+        combine(key.num_elements);
+        for (const auto& [field_name, field_type] : key.fields) {
+            combine(std::hash<std::string>{}(field_name));
+            combine(std::hash<TypeRef>{}(field_type));
+        }
+        return h;
+    }
+};
+
+static std::unordered_map<TypeKey, std::unique_ptr<TypeInfo>, TypeKeyHash> interned_types;
+// held while a type is looked up and, if new, filled in. recursive because
+// make_named interns its definition while holding it
+static std::recursive_mutex intern_mutex;
+
+size_t interned_count() {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    return interned_types.size();
+}
+
+// returns the interned type for key and whether it was newly created
+static std::pair<TypeInfo*, bool> find_or_insert(TypeKey key) {
+    auto& slot = interned_types[std::move(key)];
+    bool inserted = !slot;
+    if (inserted) {
+        slot = std::make_unique<TypeInfo>();
+    }
+    return { slot.get(), inserted };
+}
+
+namespace Intrinsics {
+
+TypeRef make_pointer(TypeRef value_type) {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    auto [info, inserted] = find_or_insert(TypeKey{pointer, value_type});
+    if (inserted) {
+        info->name = pointer;
+        info->flags = TypeInfo::pointer;
+        info->value_type = value_type;
+        info->size = pointer_size;
+        info->mangled = pointer + "._" + value_type->mangled + ".";
+    }
+    return info;
 }
 
-Type make_structure(const std::vector<Declaration>& fields) {
-    std::vector<std::variant<Type, size_t, Declaration>> f(fields.size());
-    std::transform(fields.begin(), fields.end(), f.begin(),
-        [](const auto& decl) -> std::variant<Type, size_t, Declaration> {
-            return decl;
-        });
-    return Type{structure, std::move(f)};
+TypeRef make_array(TypeRef value_type, size_t sz) {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    auto [info, inserted] = find_or_insert(TypeKey{array, value_type, sz});
+    if (inserted) {
+        info->name = array;
+        info->flags = TypeInfo::array;
+        info->value_type = value_type;
+        info->num_elements = sz;
+        info->size = sz * value_type->size;
+        info->mangled = array + "._" + value_type->mangled + "_" + std::to_string(sz) + ".";
+    }
+    return info;
 }
 
+TypeRef make_vector(TypeRef value_type, size_t lanes) {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    auto [info, inserted] = find_or_insert(TypeKey{vector, value_type, lanes});
+    if (inserted) {
+        info->name = vector;
+        info->flags = TypeInfo::vector;
+        info->value_type = value_type;
+        info->num_elements = lanes;
+        info->size = lanes * value_type->size;
+        info->mangled = vector + "._" + value_type->mangled + "_" + std::to_string(lanes) + ".";
+    }
+    return info;
 }
 
+TypeRef make_structure(const std::vector<std::pair<std::string, TypeRef>>& fields) {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    auto [info, inserted] = find_or_insert(TypeKey{structure, nullptr, 0, fields});
+    if (inserted) {
+        info->name = structure;
+        info->flags = TypeInfo::structure;
+        info->fields = fields;
+        info->size = std::accumulate(fields.begin(), fields.end(), size_t{0},
+                        [](size_t sz, const auto& field) {
+                            return sz + field.second->size;
+                        });
+        info->mangled = structure;
+        if (!fields.empty()) {
+            info->mangled += ".";
+            for (const auto& field : fields) {
+                info->mangled += "_" + field.second->mangled;
+            }
+            info->mangled += ".";
+        }
+    }
+    return info;
+}
+
+}
+
+static TypeRef intrinsic_named(const std::string& name) {
+    using namespace Intrinsics;
+    static const std::unordered_map<std::string, TypeRef> intrinsics = {
+        { void0->name,   void0   },
+        { boolean->name, boolean },
+        { integer->name, integer },
+        { int8->name,    int8    },
+        { int16->name,   int16   },
+        { int32->name,   int32   },
+        { int64->name,   int64   },
+        { natural->name, natural },
+        { nat8->name,    nat8    },
+        { nat16->name,   nat16   },
+        { nat32->name,   nat32   },
+        { nat64->name,   nat64   },
+        { float32->name, float32 },
+        { float64->name, float64 },
+    };
+    auto it = intrinsics.find(name);
+    return it == intrinsics.end() ? nullptr : it->second;
+}
+
+// vectors hold at least one lane of a scalar type
+static TypeRef vector_of(TypeRef lane_type, size_t lanes) {
+    if (!(lane_type->flags & (TypeInfo::signed_integral | TypeInfo::unsigned_integral
+                            | TypeInfo::floating_point | TypeInfo::boolean))) {
+        return error("`Vector` lanes must be integers, floating point numbers or Bools, not `"
+                     + lane_type->mangled + "`");
+    }
+    if (lanes == 0) {
+        return error("`Vector` needs at least one lane");
+    }
+    return Intrinsics::make_vector(lane_type, lanes);
+}
+
+// a typedef'd type: a distinct type with the definition's layout and the typedef's name
+static TypeRef make_named(const std::string& name, const Type& definition) {
+    std::lock_guard<std::recursive_mutex> lock(intern_mutex);
+    auto [info, inserted] = find_or_insert(TypeKey{name});
+    if (!inserted) {
+        return info;
+    }
+    // registered before the definition is interned so self-referential
+    // definitions (e.g. a field of type Pointer(Node)) find it
+    info->name = name;
+    info->mangled = name;
+
+    TypeRef def = intern(definition);
+    info->flags = def->flags;
+    info->value_type = def->value_type;
+    info->num_elements = def->num_elements;
+    info->fields = def->fields;
+    info->size = def->size;
+    return info;
+}
+
+// a size parameter: a literal, or a constant expression like `(4 * n())`
+static bool is_size(const std::variant<Type, size_t, Declaration, Expression*>& param) {
+    return std::holds_alternative<size_t>(param) || std::holds_alternative<Expression*>(param);
+}
+
+static std::optional<size_t> size_parameter(const std::variant<Type, size_t, Declaration, Expression*>& param) {
+    if (auto sz = std::get_if<size_t>(&param)) {
+        return *sz;
+    }
+    std::string why;
+    std::optional<size_t> sz = constant_size(*std::get<Expression*>(param), &why);
+    if (!sz) {
+        error("size is not a constant: " + why);
+    }
+    return sz;
+}
+
+TypeRef intern(const Type& t) {
+    if (t.parameters.empty()) {
+        if (TypeRef intrinsic = intrinsic_named(t.name)) {
+            return intrinsic;
+        }
+        if (t.name == Intrinsics::structure) {
+            return Intrinsics::make_structure({});
+        }
+        if (auto it = type_definitions.find(t.name); it != type_definitions.end()) {
+            return make_named(t.name, *it->second);
+        }
+        return error("unknown type `" + t.name + "`");
+    }
+
+    if (t.name == Intrinsics::pointer) {
+        if (t.parameters.size() != 1 || !std::holds_alternative<Type>(t.parameters[0])) {
+            return error("`Pointer` expects 1 parameter: (value type)");
+        }
+        return Intrinsics::make_pointer(intern(std::get<Type>(t.parameters[0])));
+    }
+    if (t.name == Intrinsics::array) {
+        if (t.parameters.size() != 2
+            || !std::holds_alternative<Type>(t.parameters[0])
+            || !is_size(t.parameters[1]))
+        {
+            return error("`Array` expects 2 parameters: (value type, size)");
+        }
+        std::optional<size_t> sz = size_parameter(t.parameters[1]);
+        if (!sz) {
+            return Intrinsics::void0;
+        }
+        return Intrinsics::make_array(intern(std::get<Type>(t.parameters[0])), *sz);
+    }
+    if (t.name == Intrinsics::vector) {
+        if (t.parameters.size() != 2
+            || !std::holds_alternative<Type>(t.parameters[0])
+            || !is_size(t.parameters[1]))
+        {
+            return error("`Vector` expects 2 parameters: (lane type, lanes)");
+        }
+        std::optional<size_t> lanes = size_parameter(t.parameters[1]);
+        if (!lanes) {
+            return Intrinsics::void0;
+        }
+        return vector_of(intern(std::get<Type>(t.parameters[0])), *lanes);
+    }
+    if (t.name == Intrinsics::structure) {
+        std::vector<std::pair<std::string, TypeRef>> fields;
+        for (const auto& param : t.parameters) {
+            if (!std::holds_alternative<Declaration>(param)) {
+                return error("`Struct` expects field declarations");
+            }
+            const Declaration& decl = std::get<Declaration>(param);
+            fields.emplace_back(decl.variable.name, intern(decl.type));
+        }
+        return Intrinsics::make_structure(fields);
+    }
+
+    return error("unknown type constructor `" + t.name + "`");
+}
 
-Type type_of(const Expression& expr) {
+TypeRef type_of(const Expression& expr) {
+    if (expr.type) {
+        return expr.type;
+    }
     return std::visit([](auto& v) { return type_of(v); }, expr.value);
 }
 
-Type type_of(const Variable& var) {
-    auto it = variable_definitions.find(var.name);
-    if (it == variable_definitions.end()) {
-        std::cerr << "no such variable `" << var.name << "`" << std::endl;
+TypeRef type_of(const Variable& var) {
+    if (!var.declaration) {
+        return error("no such variable `" + var.name + "`");
+    }
+    return intern(var.declaration->type);
+}
+
+// the value of an integer literal (e.g. a lane count or a shuffle index)
+static std::optional<size_t> literal_size(const Expression& expr) {
+    auto lit = std::get_if<Literal>(&expr.value);
+    if (!lit || lit->type != Literal::Type::integer) {
+        return std::nullopt;
+    }
+    return std::stoull(lit->value);
+}
+
+bool is_vector_builtin(const Invocation& invoc) {
+    if (!is_in(invoc.name, "load", "store", "splat", "extract", "insert", "shuffle",
+               "reduce_add", "reduce_mul", "reduce_min", "reduce_max", "reduce_and", "reduce_or")) {
+        return false;
+    }
+    std::vector<TypeRef> arg_types;
+    for (const Expression& arg : invoc.args) {
+        arg_types.push_back(type_of(arg));
+    }
+    return !resolve_overload(invoc.name, arg_types);
+}
+
+// load(p, lanes), store(p, v), splat(x, lanes), extract(v, i), insert(v, i, x),
+// shuffle(a, b, i...) and reduce_<op>(v). lane counts and shuffle indices are
+// integer literals
+static TypeRef vector_builtin_type(const Invocation& invoc) {
+    const std::string& name = invoc.name;
+    const auto& args = invoc.args;
+    if (name == "load") {
+        std::optional<size_t> lanes = args.size() == 2 ? literal_size(args[1]) : std::nullopt;
+        if (!lanes || !is_pointer(type_of(args[0]))) {
+            return error("`load` expects 2 parameters: (pointer, lanes)");
+        }
+        return vector_of(type_of(args[0])->value_type, *lanes);
+    }
+    if (name == "splat") {
+        std::optional<size_t> lanes = args.size() == 2 ? literal_size(args[1]) : std::nullopt;
+        if (!lanes) {
+            return error("`splat` expects 2 parameters: (value, lanes)");
+        }
+        return vector_of(type_of(args[0]), *lanes);
+    }
+    if (name == "store") {
+        if (args.size() != 2 || !is_pointer(type_of(args[0])) || !is_vector(type_of(args[1]))
+            || type_of(args[1])->value_type != type_of(args[0])->value_type)
+        {
+            return error("`store` expects 2 parameters: (pointer, vector of the pointee type)");
+        }
         return Intrinsics::void0;
     }
-    assert(it != variable_definitions.end());
-    return it->second.type;
+    if (args.empty() || !is_vector(type_of(args[0]))) {
+        return error("`" + name + "` expects a Vector");
+    }
+    const TypeRef v = type_of(args[0]);
+    if (name == "extract") {
+        if (args.size() != 2 || !is_integral(type_of(args[1]))) {
+            return error("`extract` expects 2 parameters: (vector, lane)");
+        }
+        return v->value_type;
+    }
+    if (name == "insert") {
+        if (args.size() != 3 || !is_integral(type_of(args[1])) || type_of(args[2]) != v->value_type) {
+            return error("`insert` expects 3 parameters: (vector, lane, value of the lane type)");
+        }
+        return v;
+    }
+    if (name == "shuffle") {
+        if (args.size() < 3 || type_of(args[1]) != v) {
+            return error("`shuffle` expects 2 vectors of the same type and at least one lane index");
+        }
+        for (size_t i = 2; i < args.size(); ++i) {
+            std::optional<size_t> lane = literal_size(args[i]);
+            if (!lane || *lane >= 2 * v->num_elements) {
+                return error("`shuffle` lane indices must be literals less than twice the lanes");
+            }
+        }
+        return vector_of(v->value_type, args.size() - 2);
+    }
+    // reductions
+    if (args.size() != 1) {
+        return error("`" + name + "` expects 1 parameter: (vector)");
+    }
+    if (is_in(name, "reduce_and", "reduce_or") ? is_floating_point(v->value_type)
+                                               : !(is_integral(v->value_type) || is_floating_point(v->value_type))) {
+        return error("`" + name + "` does not apply to `" + v->mangled + "`");
+    }
+    return v->value_type;
 }
 
-Type type_of(const Invocation& invoc) {
+TypeRef type_of(const Invocation& invoc) {
 
     // TODO: improve modularity
     // c functions
@@ -89,54 +471,80 @@ Type type_of(const Invocation& invoc) {
     if (invoc.name == "successor" || invoc.name == "predecessor") {
         return TypeSystem::type_of(invoc.args[0]);
     }
+    if (invoc.name == "<-") {
+        assert(invoc.args.size() == 2);
+        return TypeSystem::type_of(invoc.args[0]);
+    }
+    if (invoc.name == ".") {
+        assert(invoc.args.size() == 2);
+        TypeRef struct_type = type_of(invoc.args[0]);
+        auto field = std::get_if<Variable>(&invoc.args[1].value);
+        if (!field || !is_structure(struct_type)) {
+            return error("invalid field access");
+        }
+        int i = field_index(struct_type, field->name);
+        if (i < 0) {
+            return error("no such field `" + field->name + "`");
+        }
+        return struct_type->fields[i].second;
+    }
+    // array literal, `[a, b, ...]`
+    if (invoc.name == "[]") {
+        TypeRef element_type = type_of(invoc.args.front());
+        for (const Expression& arg : invoc.args) {
+            if (type_of(arg) != element_type) {
+                return error("the elements of an array literal must have the same type");
+            }
+        }
+        return Intrinsics::make_array(element_type, invoc.args.size());
+    }
+    if (is_vector_builtin(invoc)) {
+        return vector_builtin_type(invoc);
+    }
 
-    // TODO: use input types for overloading
-    std::vector<Type> input_types(invoc.args.size());
+    std::vector<TypeRef> input_types(invoc.args.size());
     std::transform(invoc.args.begin(), invoc.args.end(),
                    input_types.begin(),
                    [](const Expression& expr) {
                        return type_of(expr);
                    });
     if (is_intrinsic_op(invoc)) {
-        return input_types.front();
-    }
-
-    auto it = procedure_definitions.find(invoc.name);
-    if (it == procedure_definitions.end()) {
-        std::cerr << "no such procedure `" << invoc.name << "`" << std::endl;
-        return Intrinsics::void0;
-    }
-    assert(it != procedure_definitions.end());
-    assert(!it->second.empty());
-
-    const Type* return_type_ptr = nullptr;
-    for (const auto& proc : it->second) {
-        if (proc.parameters.size() != input_types.size()) {
-            continue;
+        if (is_in(invoc.name, "&&", "||")) {
+            if (input_types.front() != Intrinsics::boolean || input_types.back() != Intrinsics::boolean) {
+                return error("`" + invoc.name + "` expects Bool operands");
+            }
+            return Intrinsics::boolean;
         }
-        for (size_t i = 0; i < input_types.size(); ++i) {
-            if (input_types[i] != proc.parameters[i].type) {
-                goto next;
+        // element-wise, on vectors of the same type. comparisons give a vector of Bools
+        if (is_vector(input_types.front()) || is_vector(input_types.back())) {
+            if (input_types.front() != input_types.back()) {
+                return error("`" + invoc.name + "` expects operands of the same Vector type");
+            }
+            if (is_in(invoc.name, "=", "!=", "<", "<=", ">", ">=")) {
+                return Intrinsics::make_vector(Intrinsics::boolean, input_types.front()->num_elements);
             }
+            return input_types.front();
         }
-        return_type_ptr = &proc.return_type;
-        break;
-    next:
-    ;
+        if (is_in(invoc.name, "=", "!=", "<", "<=", ">", ">=")) {
+            return Intrinsics::boolean;
+        }
+        return input_types.front();
     }
-    if (!return_type_ptr) {
-        std::cerr << "could not find matching overload for `" << invoc.name << "`" << std::endl;
-        return Intrinsics::void0;
+
+    std::string why;
+    const Procedure* proc = resolve_overload(invoc.name, input_types, &why);
+    if (!proc) {
+        return error(why);
     }
-    return *return_type_ptr;
+    return intern(proc->return_type);
 }
 
-Type type_of(const TypeCast& cast) {
-    return cast.type;
+TypeRef type_of(const TypeCast& cast) {
+    return intern(cast.type);
 }
 
 // TODO: typeless literals
-Type type_of(const Literal& lit) {
+TypeRef type_of(const Literal& lit) {
     switch (lit.type) {
     case Literal::Type::integer:
         return Intrinsics::integer;
@@ -148,79 +556,51 @@ Type type_of(const Literal& lit) {
     default:
         assert(false);
     }
-    return Type{};
-}
-
-std::map<Type, size_t> type_sizes = {
-    {Intrinsics::boolean, 1},
-    {Intrinsics::integer, 4},
-    {Intrinsics::int8   , 1},
-    {Intrinsics::int16  , 2},
-    {Intrinsics::int32  , 4},
-    {Intrinsics::int64  , 8},
-    {Intrinsics::natural, 4},
-    {Intrinsics::nat8   , 1},
-    {Intrinsics::nat16  , 2},
-    {Intrinsics::nat32  , 4},
-    {Intrinsics::nat64  , 8},
-    {Intrinsics::float32, 4},
-    {Intrinsics::float64, 8}
-};
-
-size_t size_of(const Type& t) {
-    if (auto it = type_sizes.find(t); it != type_sizes.end()) {
-        return it->second;
-    }
-
-    if (is_pointer(t)) {
-        return pointer_size;
-    }
-
-    if (is_array(t)) {
-        return num_elements(t) * size_of(value_type(t));
-    }
-
-    if (is_structure(t)) {
-        std::vector<Type> types = field_types(t);
-        return std::accumulate(types.begin(), types.end(), 0,
-                    [](size_t sz, const Type& t2) {
-                        return sz + size_of(t2);
-                    });
-    }
+    return Intrinsics::void0;
+}
 
-    assert(false);
-    return -1;
+size_t size_of(TypeRef t) {
+    return t->size;
 }
 
-Type value_type(const Type& t) {
+TypeRef value_type(TypeRef t) {
     if (is_array(t) || is_pointer(t)) {
-        return std::get<Type>(t.parameters[0]);
+        return t->value_type;
     }
 
     return t;
 }
 
-std::vector<Type> field_types(const Type& struct_type) {
+std::vector<TypeRef> field_types(TypeRef struct_type) {
     assert(is_structure(struct_type));
 
-    std::vector<Type> types(struct_type.parameters.size());
-    std::transform(struct_type.parameters.begin(), struct_type.parameters.end(),
+    std::vector<TypeRef> types(struct_type->fields.size());
+    std::transform(struct_type->fields.begin(), struct_type->fields.end(),
                    types.begin(),
-                   [](const auto& var) {
-                       return std::get<Type>(var);
+                   [](const auto& field) {
+                       return field.second;
                    });
     return types;
 }
 
-size_t num_elements(const Type& array_type) {
-    assert(is_array(array_type));
-    return std::get<size_t>(array_type.parameters[1]);
+int field_index(TypeRef struct_type, const std::string& field) {
+    assert(is_structure(struct_type));
+
+    for (size_t i = 0; i < struct_type->fields.size(); ++i) {
+        if (struct_type->fields[i].first == field) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-template<typename First, typename ... T>
-bool is_in(First&& first, T&& ... t)
-{
-    return ((first == t) || ...);
+size_t num_elements(TypeRef array_type) {
+    assert(is_array(array_type) || is_vector(array_type));
+    return array_type->num_elements;
+}
+
+TypeRef element_type(TypeRef t) {
+    return is_vector(t) ? t->value_type : t;
 }
 
 bool is_intrinsic_op(const Invocation& invoc) {
@@ -236,44 +616,34 @@ bool is_intrinsic_op(const Invocation& invoc) {
 }
 
 
-bool is_intrinsic(const Type& t) {
-    return is_integral(t) || is_floating_point(t) || t == Intrinsics::boolean
-        || is_pointer(t) || is_array(t);
+bool is_intrinsic(TypeRef t) {
+    return t->flags & (TypeInfo::signed_integral | TypeInfo::unsigned_integral | TypeInfo::floating_point
+                     | TypeInfo::boolean | TypeInfo::pointer | TypeInfo::array | TypeInfo::vector);
 }
 
-bool is_signed_integral(const Type& t) {
-    using namespace Intrinsics;
-    return is_in(t, integer, int8, int16, int32, int64);
-}
+bool is_signed_integral  (TypeRef t) { return t->flags & TypeInfo::signed_integral; }
+bool is_unsigned_integral(TypeRef t) { return t->flags & TypeInfo::unsigned_integral; }
 
-bool is_unsigned_integral(const Type& t) {
-    using namespace Intrinsics;
-    return is_in(t, natural, nat8, nat16, nat32, nat64);
+bool is_integral(TypeRef t) {
+    return t->flags & (TypeInfo::signed_integral | TypeInfo::unsigned_integral);
 }
 
-bool is_integral(const Type& t) {
-    return is_signed_integral  (t)
-        || is_unsigned_integral(t);
+bool is_unsigned_or_ptr(TypeRef t) {
+    return t->flags & (TypeInfo::unsigned_integral | TypeInfo::pointer);
 }
 
-bool is_unsigned_or_ptr(const Type& t) {
-    return is_unsigned_integral(t) || is_pointer(t);
+bool is_integral_or_ptr(TypeRef t) {
+    return t->flags & (TypeInfo::signed_integral | TypeInfo::unsigned_integral | TypeInfo::pointer);
 }
 
-bool is_integral_or_ptr(const Type& t) {
-    return is_integral(t) || is_pointer(t);
-}
+bool is_floating_point(TypeRef t) { return t->flags & TypeInfo::floating_point; }
 
-bool is_floating_point(const Type& t) {
-    using namespace Intrinsics;
-    return is_in(t, float32, float64);
-}
+bool is_pointer(TypeRef t) { return t->flags & TypeInfo::pointer; }
 
-bool is_pointer(const Type& t) { return t.name == Intrinsics::pointer; }
+bool is_array(TypeRef t) { return t->flags & TypeInfo::array; }
+bool is_vector(TypeRef t) { return t->flags & TypeInfo::vector; }
+bool is_structure(TypeRef t) { return t->flags & TypeInfo::structure; }
 
-bool is_array(const Type& t) { return t.name == Intrinsics::array; }
-bool is_structure(const Type& t) { return t.name == Intrinsics::structure; }
+bool is_aggregate(TypeRef t) { return t->flags & (TypeInfo::array | TypeInfo::structure); }
 
-bool is_aggregate(const Type& t) { return is_array(t) || is_structure(t); }
-
-}
\ No newline at end of file
+}
@@ -2,75 +2,125 @@
 #define TYPES_HPP
 
 #include <string>
-#include <map>
+#include <vector>
+#include <utility>
 #include "parse_tree.hpp"
-#include "llvm/IR/Type.h"
-
-extern std::map<Type, llvm::Type*> types;
 
 namespace TypeSystem {
 
+// canonical representation of a type. types are interned: every distinct type
+// has exactly one TypeInfo, so equal types are equal pointers and the
+// predicates below are flag tests
+struct TypeInfo {
+    enum Flags : unsigned {
+        signed_integral   = 1 << 0,
+        unsigned_integral = 1 << 1,
+        floating_point    = 1 << 2,
+        boolean           = 1 << 3,
+        pointer           = 1 << 4,
+        array             = 1 << 5,
+        structure         = 1 << 6,
+        void0             = 1 << 7,
+        vector            = 1 << 8,
+    };
+
+    // type or type constructor name (e.g. "Int", "Pointer", or a typedef name)
+    std::string name;
+    unsigned flags = 0;
+    // pointers, arrays and vectors (the lane type)
+    const TypeInfo* value_type = nullptr;
+    size_t num_elements = 0;
+    // structures, in declaration order
+    std::vector<std::pair<std::string, const TypeInfo*>> fields;
+    size_t size = 0;
+    // name used in procedure name decoration (e.g. "Pointer._Int.")
+    std::string mangled;
+};
+
+using TypeRef = const TypeInfo*;
+
 namespace Intrinsics {
 
-extern const Type void0;
+extern const TypeRef void0;
 
-extern const Type boolean;
+extern const TypeRef boolean;
 
-extern const Type integer; 
-extern const Type int8; 
-extern const Type int16;
-extern const Type int32;
-extern const Type int64;
+extern const TypeRef integer;
+extern const TypeRef int8;
+extern const TypeRef int16;
+extern const TypeRef int32;
+extern const TypeRef int64;
 
-extern const Type natural;
-extern const Type nat8;
-extern const Type nat16;
-extern const Type nat32;
-extern const Type nat64;
+extern const TypeRef natural;
+extern const TypeRef nat8;
+extern const TypeRef nat16;
+extern const TypeRef nat32;
+extern const TypeRef nat64;
 
-extern const Type float32;
-extern const Type float64;
+extern const TypeRef float32;
+extern const TypeRef float64;
 
 // names of type constructors
 extern const std::string pointer;
 extern const std::string array;
+extern const std::string vector;
 extern const std::string structure;
 
-Type make_pointer  (const Type& value_type);
-Type make_array    (const Type& value_type, size_t sz);
-Type make_structure(const std::vector<Declaration>& fields);
+TypeRef make_pointer  (TypeRef value_type);
+TypeRef make_array    (TypeRef value_type, size_t sz);
+TypeRef make_vector   (TypeRef value_type, size_t lanes);
+TypeRef make_structure(const std::vector<std::pair<std::string, TypeRef>>& fields);
 
 } // Intrinsics
 
-Type type_of(const Expression& expr);
-Type type_of(const Variable& var);
-Type type_of(const Invocation& invoc);
-Type type_of(const TypeCast& cast);
-Type type_of(const Literal& lit);
-
-size_t size_of(const Type& t);
-Type value_type(const Type& t);
+// the canonical type for a type written in the source. typedef names
+// (type_definitions) become named types. reports an error and returns void0
+// for unknown or malformed types
+TypeRef intern(const Type& t);
+
+// O(1) for expressions annotated by the type checker
+TypeRef type_of(const Expression& expr);
+TypeRef type_of(const Variable& var);
+TypeRef type_of(const Invocation& invoc);
+TypeRef type_of(const TypeCast& cast);
+TypeRef type_of(const Literal& lit);
+
+// number of type errors reported so far
+size_t error_count();
+// number of distinct types interned so far
+size_t interned_count();
+
+size_t size_of(TypeRef t);
+TypeRef value_type(TypeRef t);
 // precondition: is_structure(struct_type)
-std::vector<Type> field_types(const Type& struct_type);
-// precondition: is_array(array_type)
-size_t num_elements(const Type& array_type);
+std::vector<TypeRef> field_types(TypeRef struct_type);
+// precondition: is_structure(struct_type). returns -1 if there is no such field
+int field_index(TypeRef struct_type, const std::string& field);
+// precondition: is_array(array_type) || is_vector(array_type)
+size_t num_elements(TypeRef array_type);
+// the lane type of a vector, otherwise t itself. element-wise ops dispatch on it
+TypeRef element_type(TypeRef t);
 
 // returns true if the procedure is intrinsic and its parameters are all intrinsic
 bool is_intrinsic_op(const Invocation& invoc);
-
-bool is_intrinsic        (const Type& t);
-bool is_signed_integral  (const Type& t);
-bool is_unsigned_integral(const Type& t);
-bool is_unsigned_integral(const Type& t);
-bool is_integral         (const Type& t);
-bool is_unsigned_or_ptr  (const Type& t);
-bool is_integral_or_ptr  (const Type& t);
-bool is_floating_point   (const Type& t);
-bool is_pointer          (const Type& t);
-bool is_array            (const Type& t);
-bool is_structure        (const Type& t);
-bool is_aggregate        (const Type& t);
+// a call of load, store, splat, extract, insert, shuffle or a reduce_ procedure
+// on Vectors. a procedure of the program with one of these names that fits the
+// arguments is called instead
+bool is_vector_builtin(const Invocation& invoc);
+
+bool is_intrinsic        (TypeRef t);
+bool is_signed_integral  (TypeRef t);
+bool is_unsigned_integral(TypeRef t);
+bool is_integral         (TypeRef t);
+bool is_unsigned_or_ptr  (TypeRef t);
+bool is_integral_or_ptr  (TypeRef t);
+bool is_floating_point   (TypeRef t);
+bool is_pointer          (TypeRef t);
+bool is_array            (TypeRef t);
+bool is_vector           (TypeRef t);
+bool is_structure        (TypeRef t);
+bool is_aggregate        (TypeRef t);
 
 } // TypeSystem
 
-#endif
\ No newline at end of file
+#endif